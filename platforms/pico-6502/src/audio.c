@@ -8,6 +8,9 @@
 #include "hardware/sync.h"
 #include "hardware/clocks.h"
 
+#define CHIPS_IMPL
+#include "util/audiomix.h"
+
 #include "audio.h"
 
 #define REPETITION_RATE 4
@@ -25,7 +28,7 @@ struct MIXER_SOURCE {
     int len;
     int loop_start;
     int pos;
-    bool active;
+    volatile bool active;  // Set last when starting, the mixer interrupt may read the source any time
     bool loop;
     uint16_t volume;  // 8.8 fixed point
 };
@@ -33,15 +36,36 @@ struct MIXER_SOURCE {
 static struct MIXER_SOURCE mixer_sources[AUDIO_MAX_SOURCES];
 static int16_t mixer_buffer[AUDIO_BUFFER_SIZE];
 
+// Emulator stream, a single-producer/single-consumer ring. audio_push() only
+// advances ring_write, the DMA interrupt only advances ring_read.
+static uint8_t audio_ring[AUDIO_RING_SIZE];
+static volatile uint32_t ring_write;
+static volatile uint32_t ring_read;
+static volatile bool ring_primed;  // Playing, cleared when the ring runs dry
+static uint8_t ring_last = 128;    // Last sample played, held while the ring is empty
+static int32_t ring_avg_fill;      // Smoothed fill level, 8 fractional bits
+static int32_t ring_drift;         // Integrated fill error, 6 fractional bits
+static volatile int32_t rate_adjust;
+static volatile uint32_t ring_underruns;
+static volatile uint32_t ring_overruns;
+static volatile uint32_t ring_fill;
+
+static int audio_sample_freq;
+static uint32_t pacing_frac;  // Fractional ticks carried between pacing slices, in 1/audio_sample_freq
+
 static void __isr __time_critical_func(dma_handler)() {
     cur_audio_buffer = 1 - cur_audio_buffer;
     dma_hw->ch[sample_dma_chan].al1_read_addr = (intptr_t)&audio_buffers[cur_audio_buffer][0];
     dma_hw->ch[trigger_dma_chan].al3_read_addr_trig = (intptr_t)&single_sample_ptr;
 
     dma_hw->ints1 = 1u << trigger_dma_chan;
+
+    // Refill the buffer that just finished playing, a timer couldn't keep in step with the DMA
+    audio_mixer_step();
 }
 
 void audio_init(int audio_pin, int sample_freq) {
+    audio_sample_freq = sample_freq;
     gpio_set_function(audio_pin, GPIO_FUNC_PWM);
 
     int audio_pin_slice = pwm_gpio_to_slice_num(audio_pin);
@@ -103,6 +127,9 @@ void audio_init(int audio_pin, int sample_freq) {
                           false  // don't start yet
     );
 
+    // start the stream at the target fill level
+    ring_avg_fill = AUDIO_RING_TARGET << 8;
+
     // clear audio buffers
     memset(audio_buffers[0], 128, AUDIO_BUFFER_SIZE);
     memset(audio_buffers[1], 128, AUDIO_BUFFER_SIZE);
@@ -121,102 +148,164 @@ uint8_t *audio_get_buffer(void) {
     return buf;
 }
 
-static int audio_claim_unused_source(void) {
+static int audio_start_source(const uint8_t *samples, int len, bool loop, int loop_start) {
     for (int i = 0; i < AUDIO_MAX_SOURCES; i++) {
-        if (!mixer_sources[i].active) {
-            mixer_sources[i].active = true;
+        struct MIXER_SOURCE *source = &mixer_sources[i];
+        if (!source->active) {
+            source->samples = samples;
+            source->len = len;
+            source->pos = 0;
+            source->loop = loop && (loop_start < len);
+            source->loop_start = loop_start;
+            source->volume = AUDIOMIX_UNITY_VOLUME;
+            __dmb();
+            source->active = true;
             return i;
         }
     }
     return -1;
 }
 
-int audio_play_once(const uint8_t *samples, int len) {
-    int source_id = audio_claim_unused_source();
-    if (source_id < 0) {
-        return -1;
+int audio_play_once(const uint8_t *samples, int len) { return audio_start_source(samples, len, false, 0); }
+
+int audio_play_loop(const uint8_t *samples, int len, int loop_start) {
+    return audio_start_source(samples, len, true, loop_start);
+}
+
+int audio_push(const uint8_t *samples, int len) {
+    uint32_t w = ring_write;
+    uint32_t space = AUDIO_RING_SIZE - (w - ring_read);
+    if ((uint32_t)len > space) {
+        len = space;
+        ring_overruns++;
     }
-    struct MIXER_SOURCE *source = &mixer_sources[source_id];
-    source->samples = samples;
-    source->len = len;
-    source->pos = 0;
-    source->loop = false;
-    source->volume = 256;
-    return source_id;
+    uint32_t pos = w & (AUDIO_RING_SIZE - 1);
+    uint32_t first = (len < AUDIO_RING_SIZE - pos) ? len : AUDIO_RING_SIZE - pos;
+    memcpy(&audio_ring[pos], samples, first);
+    memcpy(audio_ring, samples + first, len - first);
+    // Samples must be in the ring before the consumer sees the new write position
+    __dmb();
+    ring_write = w + len;
+    return len;
 }
 
-int audio_play_loop(const uint8_t *samples, int len, int loop_start) {
-    int source_id = audio_play_once(samples, len);
-    if (source_id < 0) {
-        return -1;
+int32_t audio_get_rate_adjust(void) { return rate_adjust; }
+
+void audio_get_stats(audio_stats_t *stats) {
+    stats->underruns = ring_underruns;
+    stats->overruns = ring_overruns;
+    stats->fill = ring_fill;
+    stats->rate_adjust = rate_adjust;
+}
+
+uint32_t audio_get_pacing_ticks(uint32_t tick_hz) {
+    // Keep producing until playback starts, samples the system still holds never show up in the ring
+    uint32_t fill = ring_write - ring_read;
+    if (ring_primed && (fill + AUDIO_PACING_SLICE > AUDIO_RING_TARGET)) {
+        return 0;
     }
-    struct MIXER_SOURCE *source = &mixer_sources[source_id];
-    source->loop = true;
-    source->loop_start = loop_start;
-    return source_id;
+    uint64_t ticks = (uint64_t)tick_hz * AUDIO_PACING_SLICE + pacing_frac;
+    pacing_frac = (uint32_t)(ticks % (uint32_t)audio_sample_freq);
+    return (uint32_t)(ticks / (uint32_t)audio_sample_freq);
 }
 
-void audio_source_stop(int source_id) { mixer_sources[source_id].active = false; }
+// Fill a DMA buffer from the stream and update the rate control
+static void __time_critical_func(audio_stream_pull)(uint8_t *audiobuf) {
+    uint32_t r = ring_read;
+    uint32_t fill = ring_write - r;
+    __dmb();
+    if (!ring_primed && (fill >= AUDIO_RING_TARGET)) {
+        ring_primed = true;
+    }
 
-void audio_source_set_volume(int source_id, uint16_t volume) { mixer_sources[source_id].volume = volume; }
+    uint32_t len = 0;
+    if (ring_primed) {
+        len = (fill < AUDIO_BUFFER_SIZE) ? fill : AUDIO_BUFFER_SIZE;
+        uint32_t pos = r & (AUDIO_RING_SIZE - 1);
+        uint32_t first = (len < AUDIO_RING_SIZE - pos) ? len : AUDIO_RING_SIZE - pos;
+        memcpy(audiobuf, &audio_ring[pos], first);
+        memcpy(audiobuf + first, audio_ring, len - first);
+        if (len > 0) {
+            ring_last = audiobuf[len - 1];
+        }
+        if (len < AUDIO_BUFFER_SIZE) {
+            // Wait for a full ring again instead of stuttering on every buffer
+            ring_underruns++;
+            ring_primed = false;
+        }
+        __dmb();
+        ring_read = r + len;
+    }
+    memset(audiobuf + len, ring_last, AUDIO_BUFFER_SIZE - len);
+
+    // Slow proportional-integral control on the fill level smoothed over about 16 buffers,
+    // the integral takes over the clock drift so the fill returns to the target
+    fill -= len;
+    ring_fill = fill;
+    ring_avg_fill += (((int32_t)fill << 8) - ring_avg_fill) >> 4;
+    int32_t error = AUDIO_RING_TARGET - (ring_avg_fill >> 8);
+    ring_drift += error;
+    if (ring_drift > (AUDIO_RATE_ADJUST_MAX << 6)) {
+        ring_drift = AUDIO_RATE_ADJUST_MAX << 6;
+    } else if (ring_drift < -(AUDIO_RATE_ADJUST_MAX << 6)) {
+        ring_drift = -(AUDIO_RATE_ADJUST_MAX << 6);
+    }
+    int32_t adjust = error * 2 + (ring_drift >> 6);
+    if (adjust > AUDIO_RATE_ADJUST_MAX) {
+        adjust = AUDIO_RATE_ADJUST_MAX;
+    } else if (adjust < -AUDIO_RATE_ADJUST_MAX) {
+        adjust = -AUDIO_RATE_ADJUST_MAX;
+    }
+    rate_adjust = adjust;
+}
+
+void audio_source_stop(int source_id) { mixer_sources[source_id].active = false; }
 
-extern void copy_audiobuf(uint8_t *dest, const uint8_t *src);
+void audio_source_set_volume(int source_id, uint16_t volume) {
+    mixer_sources[source_id].volume = (volume < AUDIOMIX_MAX_VOLUME) ? volume : AUDIOMIX_MAX_VOLUME;
+}
 
-void audio_mixer_step(void) {
+// Mix one buffer, called from the DMA interrupt
+void __time_critical_func(audio_mixer_step)(void) {
     uint8_t *audiobuf = audio_get_buffer();
     if (!audiobuf) return;
 
-    struct MIXER_SOURCE *source = &mixer_sources[0];
-    if (!source->active) return;
-
-    copy_audiobuf(audiobuf, source->samples + source->pos);
-    source->pos += AUDIO_BUFFER_SIZE;
-    // handle source termination
-    if (source->pos == source->len) {
-        if (source->loop) {
-            source->pos = source->loop_start;
-        } else {
-            source->active = false;
+    // The emulator stream goes straight to the output, other sources are mixed on top of it
+    audio_stream_pull(audiobuf);
+
+    bool mixing = false;
+    for (int i = 0; i < AUDIO_MAX_SOURCES; i++) {
+        struct MIXER_SOURCE *source = &mixer_sources[i];
+        if (!source->active) continue;
+        if (!mixing) {
+            audiomix_clear(mixer_buffer, AUDIO_BUFFER_SIZE);
+            audiomix_add(mixer_buffer, audiobuf, AUDIO_BUFFER_SIZE, AUDIOMIX_UNITY_VOLUME);
+            mixing = true;
+        }
+
+        int pos = 0;
+        while ((pos < AUDIO_BUFFER_SIZE) && source->active) {
+            int mix_len = source->len - source->pos;
+            if (mix_len > AUDIO_BUFFER_SIZE - pos) {
+                mix_len = AUDIO_BUFFER_SIZE - pos;
+            }
+            audiomix_add(&mixer_buffer[pos], source->samples + source->pos, mix_len, source->volume);
+            pos += mix_len;
+            source->pos += mix_len;
+
+            // handle source termination
+            if (source->pos == source->len) {
+                if (source->loop) {
+                    source->pos = source->loop_start;
+                } else {
+                    source->active = false;
+                }
+            }
         }
     }
 
-    // // setup 16-bit mixer buffer
-    // memset(mixer_buffer, 0, sizeof(mixer_buffer));
-
-    // // mix to 16-bit mixer buffer
-    // for (int i = 0; i < AUDIO_MAX_SOURCES; i++) {
-    //   if (! mixer_sources[i].active) continue;
-    //   struct MIXER_SOURCE *source = &mixer_sources[i];
-
-    //   // mix source
-    //   int mix_len = source->len - source->pos;
-    //   if (mix_len > AUDIO_BUFFER_SIZE) {
-    //     mix_len = AUDIO_BUFFER_SIZE;
-    //   }
-    //   for (int i = 0; i < mix_len; i++) {
-    //     mixer_buffer[i] += ((source->samples[i+source->pos]-128) * source->volume) >> 8;
-    //   }
-    //   source->pos += mix_len;
-
-    //   // handle source termination
-    //   if (source->pos == source->len) {
-    //     if (source->loop) {
-    //       source->pos = source->loop_start;
-    //     } else {
-    //       source->active = false;
-    //     }
-    //   }
-    // }
-
-    // // convert 16-bit mixer buffer to 8-bit output buffer
-    // for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
-    //   int sample = mixer_buffer[i] + 128;
-    //   if (sample < 0) {
-    //     audio_buffer[i] = 0;
-    //   } else if (sample > 255) {
-    //     audio_buffer[i] = 255;
-    //   } else {
-    //     audio_buffer[i] = sample;
-    //   }
-    // }
+    if (mixing) {
+        // convert the 16-bit mixer buffer back to 8-bit output samples
+        audiomix_store(audiobuf, mixer_buffer, AUDIO_BUFFER_SIZE);
+    }
 }
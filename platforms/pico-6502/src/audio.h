@@ -1,8 +1,39 @@
 #ifndef AUDIO_H_FILE
 #define AUDIO_H_FILE
 
-#define AUDIO_BUFFER_SIZE 1024
-#define AUDIO_MAX_SOURCES 1
+// Samples per DMA buffer, two of them alternate. Small buffers keep the latency low,
+// each one costs a DMA interrupt that mixes the next.
+#ifndef AUDIO_BUFFER_SIZE
+#define AUDIO_BUFFER_SIZE 128
+#endif
+#if (AUDIO_BUFFER_SIZE < 64) || (AUDIO_BUFFER_SIZE > 1024)
+#error "AUDIO_BUFFER_SIZE must be between 64 and 1024"
+#endif
+#define AUDIO_MAX_SOURCES 4
+
+// Pace the emulation by the audio clock instead of the system timer: the main loop runs
+// as many ticks as the DMA has consumed samples, in slices of AUDIO_PACING_SLICE samples
+#ifndef AUDIO_PACING
+#define AUDIO_PACING 0
+#endif
+#define AUDIO_PACING_SLICE 32   // About 1.5 ms at 22050 Hz
+#define AUDIO_PACING_STALL 384  // Longest emulator pause the ring covers, about 17 ms at 22050 Hz
+
+// Stream ring between the emulator and the DMA buffers, power of 2
+#define AUDIO_RING_SIZE 4096
+// Fill level the rate control keeps the ring at, playback starts once it's reached.
+// It covers the emulator pausing for screen updates and USB handling. Pacing stops the
+// emulation at the target, so there it has to hold a stall on top of the system's block,
+// the next DMA buffer and a slice, whatever the buffer size.
+#ifndef AUDIO_RING_TARGET
+#if AUDIO_PACING
+#define AUDIO_RING_TARGET (AUDIO_PACING_STALL + 2 * AUDIO_BUFFER_SIZE + AUDIO_PACING_SLICE)
+#else
+#define AUDIO_RING_TARGET (4 * AUDIO_BUFFER_SIZE)
+#endif
+#endif
+// Largest output rate correction in parts per million
+#define AUDIO_RATE_ADJUST_MAX 5000
 
 #include <stdint.h>
 
@@ -21,6 +52,25 @@ void audio_source_set_volume(int source_id, uint16_t volume);
 
 void audio_mixer_step(void);
 
+// Stream statistics, the counters are never reset
+typedef struct {
+    uint32_t underruns;   // Buffers padded because the ring ran dry
+    uint32_t overruns;    // Pushes cut short because the ring was full
+    uint32_t fill;        // Samples in the ring after the last buffer was taken
+    int32_t rate_adjust;  // Current output rate correction in ppm
+} audio_stats_t;
+
+// Append emulator samples to the stream, returns the number of samples that fit.
+// Call from one producer only, the DMA interrupt is the only consumer.
+int audio_push(const uint8_t *samples, int len);
+// Output rate correction in ppm that keeps the ring at AUDIO_RING_TARGET,
+// positive when the producer should generate samples faster
+int32_t audio_get_rate_adjust(void);
+void audio_get_stats(audio_stats_t *stats);
+// Emulator ticks to run for the next AUDIO_PACING_SLICE samples once the ring has room for them
+// below AUDIO_RING_TARGET, 0 while it hasn't. The fractional tick is carried to the next slice.
+uint32_t audio_get_pacing_ticks(uint32_t tick_hz);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,17 +23,22 @@
 
 #include "chips/chips_common.h"
 #include "chips/wdc65C02cpu.h"
+#include "chips/resampler.h"
 #include "chips/beeper.h"
+#include "chips/mos6522via.h"
+#include "chips/ay38910psg.h"
 #include "chips/kbd.h"
 #include "chips/mem.h"
 #include "chips/clk.h"
 #include "devices/apple2_lc.h"
+#include "devices/disk2_nib.h"
 #include "devices/disk2_fdd.h"
 #include "devices/disk2_fdc.h"
 #include "devices/apple2_fdc_rom.h"
 #include "devices/prodos_hdd.h"
 #include "devices/prodos_hdc.h"
 #include "devices/prodos_hdc_rom.h"
+#include "devices/mockingboard.h"
 #include "systems/apple2e.h"
 
 #include "hardware/clocks.h"
@@ -69,10 +74,10 @@ typedef struct {
 
 static state_t __not_in_flash() state;
 
-// audio-streaming callback
+// audio-streaming callback, the samples are copied into the audio ring before the system reuses its buffer
 static void push_audio(const uint8_t *samples, int num_samples, void *user_data) {
     (void)user_data;
-    audio_play_once(samples, num_samples);
+    audio_push(samples, num_samples);
 }
 
 // get apple2e_desc_t struct based on joystick type
@@ -80,10 +85,13 @@ apple2e_desc_t apple2e_desc(void) {
     return (apple2e_desc_t){
         .fdc_enabled = false,
         .hdc_enabled = true,
+        .mockingboard_enabled = false,
         .hdc_internal_flash = true,
+        .shared_lines = true,
         .audio =
             {
                 .callback = {.func = push_audio},
+                .num_samples = AUDIO_BUFFER_SIZE,
                 .sample_rate = 22050,
             },
         .roms =
@@ -211,22 +219,42 @@ static inline void __not_in_flash_func(render_empty_scanlines)() {
     }
 }
 
+#if APPLE2E_FRAMEBUFFER
+// The 20 Hz timer rewrites fb and fb_line[] while they're scanned out, a frame can show two updates
 static inline void __not_in_flash_func(render_frame)() {
-    for (int y = 0; y < APPLE2E_SCREEN_HEIGHT; y += 2) {
+    uint32_t *prev_tmdsbuf = NULL;
+    for (int y = 0; y < APPLE2E_SCREEN_HEIGHT; y++) {
         uint32_t *tmdsbuf;
+        uint8_t row = state.apple2e.fb_line[y];
         queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
-        render_scanline((const uint32_t *)(&state.apple2e.fb[y * 280]), (uint32_t *)(&scanbuf[APPLE2E_EMPTY_COLUMNS]),
-                        280);
-        tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
+        if (prev_tmdsbuf && (row == state.apple2e.fb_line[y - 1])) {
+            // Scanline shares its fb row with the previous one, reuse the encoded line
+            copy_tmdsbuf(tmdsbuf, prev_tmdsbuf);
+        } else {
+            render_scanline((const uint32_t *)(&state.apple2e.fb[row * 280]), (uint32_t *)(&scanbuf[APPLE2E_EMPTY_COLUMNS]),
+                            280);
+            tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
+        }
         queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
+        prev_tmdsbuf = tmdsbuf;
+    }
+}
+#else
+// Lines are rendered from RAM right before they're encoded, there's no framebuffer. Like the real video
+// circuitry, a line shows RAM as it is when the line is scanned, no buffer is ever half rewritten.
+static uint32_t __not_in_flash() linebuf[280 / 4];
 
+static inline void __not_in_flash_func(render_frame)() {
+    for (int y = 0; y < APPLE2E_SCREEN_HEIGHT; y++) {
+        uint32_t *tmdsbuf;
         queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
-        render_scanline((const uint32_t *)(&state.apple2e.fb[(y + 1) * 280]),
-                        (uint32_t *)(&scanbuf[APPLE2E_EMPTY_COLUMNS]), 280);
+        apple2e_render_line(&state.apple2e, y, (uint8_t *)linebuf);
+        render_scanline(linebuf, (uint32_t *)(&scanbuf[APPLE2E_EMPTY_COLUMNS]), 280);
         tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
         queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
     }
 }
+#endif
 
 void __not_in_flash_func(core1_main()) {
     dvi_register_irqs_this_core(&dvi0, DMA_IRQ_0);
@@ -241,11 +269,12 @@ void __not_in_flash_func(core1_main()) {
     __builtin_unreachable();
 }
 
+#if APPLE2E_FRAMEBUFFER
 bool __not_in_flash_func(repeating_timer_20hz_callback)(struct repeating_timer *t) {
-    audio_mixer_step();
     apple2e_screen_update(&state.apple2e);
     return true;
 }
+#endif
 
 int main() {
     vreg_set_voltage(VREG_VSEL);
@@ -272,12 +301,26 @@ int main() {
 
     app_init();
 
+#if APPLE2E_FRAMEBUFFER
     struct repeating_timer timer_20hz;
     add_repeating_timer_us(-50000, repeating_timer_20hz_callback, NULL, &timer_20hz);
+#endif
 
     while (1) {
         tuh_task();
 
+#if AUDIO_PACING
+        // Run the next slice once the audio output has room for it, the DMA clock paces the emulation
+        uint32_t num_ticks = audio_get_pacing_ticks(APPLE2E_FREQUENCY);
+        if (num_ticks == 0) {
+            __wfi();
+            continue;
+        }
+        for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
+            apple2e_tick(&state.apple2e);
+        }
+        apple2e_flush_audio(&state.apple2e);
+#else
         struct timeval tv;
         gettimeofday(&tv, NULL);
         uint64_t start_time_in_micros = 1000000 * tv.tv_sec + tv.tv_usec;
@@ -286,6 +329,9 @@ int main() {
         for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
             apple2e_tick(&state.apple2e);
         }
+        apple2e_flush_audio(&state.apple2e);
+        // Keep the audio ring at its target fill level
+        apple2e_set_audio_rate_adjust(&state.apple2e, audio_get_rate_adjust());
 
         gettimeofday(&tv, NULL);
         uint64_t end_time_in_micros = 1000000 * tv.tv_sec + tv.tv_usec;
@@ -296,6 +342,7 @@ int main() {
         if (sleep_time > 0) {
             sleep_us(sleep_time);
         }
+#endif
     }
 
     __builtin_unreachable();
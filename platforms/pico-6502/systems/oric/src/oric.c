@@ -17,15 +17,18 @@
 #include "chips/chips_common.h"
 #include "chips/wdc65C02cpu.h"
 #include "chips/mos6522via.h"
+#include "chips/resampler.h"
 #include "chips/ay38910psg.h"
 #include "chips/kbd.h"
 #include "chips/mem.h"
 #include "chips/clk.h"
 #include "devices/oric_td.h"
+#include "devices/disk2_nib.h"
 #include "devices/disk2_fdd.h"
 #include "devices/disk2_fdc.h"
 #include "devices/oric_fdc_rom.h"
 #include "systems/oric.h"
+#include "util/triplebuf.h"
 
 #include "hardware/clocks.h"
 #include "hardware/dma.h"
@@ -62,10 +65,14 @@ typedef struct {
 
 state_t __not_in_flash() state;
 
-// audio-streaming callback
+// Frames handed from the 20 Hz screen update to the DVI loop on core 1, the system renders into the back buffer
+static uint8_t frame_buffers[3 * ORIC_FRAMEBUFFER_SIZE];
+triplebuf_t __not_in_flash() frame_buf;
+
+// audio-streaming callback, the samples are copied into the audio ring before the system reuses its buffer
 static void push_audio(const uint8_t *samples, int num_samples, void *user_data) {
     (void)user_data;
-    audio_play_once(samples, num_samples);
+    audio_push(samples, num_samples);
 }
 
 // get oric_desc_t struct based on joystick type
@@ -76,6 +83,7 @@ oric_desc_t oric_desc(void) {
         .audio =
             {
                 .callback = {.func = push_audio},
+                .num_samples = AUDIO_BUFFER_SIZE,
                 .sample_rate = 22050,
             },
         .roms =
@@ -89,6 +97,9 @@ oric_desc_t oric_desc(void) {
 void app_init(void) {
     oric_desc_t desc = oric_desc();
     oric_init(&state.oric, &desc);
+#if ORIC_EXTERNAL_FRAMEBUFFER
+    state.oric.fb = triplebuf_back(&frame_buf);
+#endif
 }
 
 // TMDS bit clock 295.2 MHz
@@ -207,15 +218,16 @@ static inline void __not_in_flash_func(render_empty_scanlines)() {
 }
 
 static inline void __not_in_flash_func(render_frame)() {
+    const uint8_t *fb = triplebuf_consume(&frame_buf);
     for (int y = 0; y < ORIC_SCREEN_HEIGHT; y += 2) {
         uint32_t *tmdsbuf;
         queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
-        render_scanline((const uint32_t *)(&state.oric.fb[y * 120]), (uint32_t *)(&scanbuf[ORIC_EMPTY_COLUMNS]), 120);
+        render_scanline((const uint32_t *)(&fb[y * 120]), (uint32_t *)(&scanbuf[ORIC_EMPTY_COLUMNS]), 120);
         tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
         queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
 
         queue_remove_blocking_u32(&dvi0.q_tmds_free, &tmdsbuf);
-        render_scanline((const uint32_t *)(&state.oric.fb[(y + 1) * 120]), (uint32_t *)(&scanbuf[ORIC_EMPTY_COLUMNS]), 120);
+        render_scanline((const uint32_t *)(&fb[(y + 1) * 120]), (uint32_t *)(&scanbuf[ORIC_EMPTY_COLUMNS]), 120);
         tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
         queue_add_blocking_u32(&dvi0.q_tmds_valid, &tmdsbuf);
     }
@@ -235,8 +247,14 @@ void __not_in_flash_func(core1_main()) {
 }
 
 bool __not_in_flash_func(repeating_timer_20hz_callback)(struct repeating_timer *t) {
-    audio_mixer_step();
     oric_screen_update(&state.oric);
+#if ORIC_EXTERNAL_FRAMEBUFFER
+    triplebuf_publish_back(&frame_buf, state.oric.fb_dirty_rows);
+    state.oric.fb = triplebuf_back(&frame_buf);
+#else
+    triplebuf_publish(&frame_buf, state.oric.fb, state.oric.fb_dirty_rows);
+#endif
+    memset(state.oric.fb_dirty_rows, 0, sizeof(state.oric.fb_dirty_rows));
     return true;
 }
 
@@ -259,6 +277,12 @@ int main() {
     tmds_palette_init();
     tmds_encode_palette_data((const uint32_t *)scanbuf, tmds_palette, empty_tmdsbuf, FRAME_WIDTH, PALETTE_BITS);
 
+    triplebuf_init(&frame_buf, &(triplebuf_desc_t){
+                                   .pitch = ORIC_SCREEN_WIDTH / 2,
+                                   .height = ORIC_SCREEN_HEIGHT,
+                                   .buffers = {.ptr = frame_buffers, .size = sizeof(frame_buffers)},
+                               });
+
     printf("Core 1 start\n");
     hw_set_bits(&bus_ctrl_hw->priority, BUSCTRL_BUS_PRIORITY_PROC1_BITS);
     multicore_launch_core1(core1_main);
@@ -271,6 +295,19 @@ int main() {
     while (1) {
         tuh_task();
 
+#if AUDIO_PACING
+        // Run the next slice once the audio output has room for it, the DMA clock paces the emulation
+        uint32_t num_ticks = audio_get_pacing_ticks(ORIC_FREQUENCY);
+        if (num_ticks == 0) {
+            __wfi();
+            continue;
+        }
+        for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
+            oric_tick(&state.oric);
+        }
+        oric_flush_audio(&state.oric);
+        kbd_update(&state.oric.kbd, num_ticks);  // ticks are microseconds at 1 MHz
+#else
         struct timeval tv;
         gettimeofday(&tv, NULL);
         uint64_t start_time_in_micros = 1000000 * tv.tv_sec + tv.tv_usec;
@@ -279,6 +316,9 @@ int main() {
         for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
             oric_tick(&state.oric);
         }
+        oric_flush_audio(&state.oric);
+        // Keep the audio ring at its target fill level
+        resampler_set_rate_adjust(&state.oric.psg.resampler, audio_get_rate_adjust());
 
         gettimeofday(&tv, NULL);
         uint64_t end_time_in_micros = 1000000 * tv.tv_sec + tv.tv_usec;
@@ -291,6 +331,7 @@ int main() {
         }
 
         kbd_update(&state.oric.kbd, 1000);
+#endif
     }
 
     __builtin_unreachable();
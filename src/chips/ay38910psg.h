@@ -11,6 +11,8 @@
 
     CHIPS_ASSERT(c)     -- your own assert macro (default: assert(c))
 
+    Include chips/resampler.h before this file.
+
     EMULATED PINS:
 
              +-----------+
@@ -96,8 +98,11 @@ extern "C" {
 #define AY38910PSG_FIXEDPOINT_SCALE (16)
 // number of channels
 #define AY38910PSG_NUM_CHANNELS (3)
-// DC adjustment buffer length
-#define AY38910PSG_DCADJ_BUFLEN (512)
+// DC adjustment filter time constant, 1 << AY38910PSG_DCADJ_SHIFT samples
+#define AY38910PSG_DCADJ_SHIFT (9)
+// input clock ticks per tone/noise generator step, and per envelope generator step
+#define AY38910PSG_CHANNEL_TICKS  (64)
+#define AY38910PSG_ENVELOPE_TICKS (128)
 
 // IO port names
 #define AY38910PSG_PORT_A (0)
@@ -124,6 +129,8 @@ typedef struct {
     ay38910psg_in_t in_cb;   /* I/O port input callback */
     ay38910psg_out_t out_cb; /* I/O port output callback */
     void* user_data;         /* optional user-data for callbacks */
+    int tick_hz;             /* input clock frequency, only needed for ay38910psg_render() */
+    int sound_hz;            /* output sample rate, only needed for ay38910psg_render() */
 } ay38910psg_desc_t;
 
 // a tone channel
@@ -185,12 +192,18 @@ typedef struct {
     ay38910psg_noise_t noise;                         // the noise generator state
     ay38910psg_env_t env;                             // the envelope generator state
 
-    // sample generation state
+    // sample generation state, levels have RESAMPLER_ONE as full scale
+#if RESAMPLER_FIXEDPOINT
+    uint16_t volumes[16];  // channel levels scaled by the magnitude
+#else
     float mag;
-    float sample;
-    float dcadj_sum;
-    uint32_t dcadj_pos;
-    float dcadj_buf[AY38910PSG_DCADJ_BUFLEN];
+#endif
+    resampler_level_t sample;
+    resampler_level_t dcadj_level;  // average level removed by the DC adjust filter
+
+    // block mode, see ay38910psg_render()
+    uint32_t tick;          // first tick not rendered yet
+    resampler_t resampler;  // band-limited output level
 } ay38910psg_t;
 
 // initialize a AY-3-8910 instance
@@ -203,6 +216,10 @@ void ay38910psg_tick_channels(ay38910psg_t* c);
 void ay38910psg_tick_envelope_generator(ay38910psg_t* c);
 
 void ay38910psg_tick_sample_generator(ay38910psg_t* c);
+// run the generators from the last rendered tick up to end_tick and return the number of band-limited samples
+// written to out, call again with the same end_tick while it returns max_samples. Render up to the current tick
+// before each register write so the change lands at the tick it was made, instead of ticking the chip every cycle.
+int ay38910psg_render(ay38910psg_t* c, uint32_t end_tick, resampler_level_t* out, int max_samples);
 
 uint8_t ay38910psg_read(ay38910psg_t* c);
 
@@ -247,6 +264,11 @@ static const uint8_t _ay38910psg_reg_mask[AY38910PSG_NUM_REGISTERS] = {
     0xFF,  // AY38910PSG_REG_IO_PORT_B
 };
 
+#if RESAMPLER_FIXEDPOINT
+// volume table from: https://github.com/true-grue/ayumi/blob/master/ayumi.c, scaled to RESAMPLER_ONE
+static const uint16_t _ay38910psg_volumes[16] = {0,    164,  237,  345,  503,   746,   1057,  1759,
+                                                 2074, 3359, 4788, 6109, 8070, 10409, 13199, 16384};
+#else
 // volume table from: https://github.com/true-grue/ayumi/blob/master/ayumi.c
 static const float _ay38910psg_volumes[16] = {0.0f,
                                               0.00999465934234f,
@@ -264,6 +286,7 @@ static const float _ay38910psg_volumes[16] = {0.0f,
                                               0.635324635691f,
                                               0.805584802014f,
                                               1.0f};
+#endif
 
 // canned envelope generator shapes
 static const uint8_t _ay38910psg_shapes[16][32] = {
@@ -298,17 +321,19 @@ static const uint8_t _ay38910psg_shapes[16][32] = {
     {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
 };
 
-/* DC adjustment filter from StSound, this moves an "offcenter"
-   signal back to the zero-line (e.g. the volume-level output
-   from the chip simulation which is >0.0 gets converted to
-   a +/- sample value)
+/* DC adjustment filter, this moves an "offcenter" signal back
+   to the zero-line (e.g. the volume-level output from the chip
+   simulation which is >0 gets converted to a +/- sample value),
+   the average is a one-pole lowpass instead of StSound's moving
+   average, so no sample history is kept
 */
-static float _ay38910psg_dcadjust(ay38910psg_t* c, float s) {
-    c->dcadj_sum -= c->dcadj_buf[c->dcadj_pos];
-    c->dcadj_sum += s;
-    c->dcadj_buf[c->dcadj_pos] = s;
-    c->dcadj_pos = (c->dcadj_pos + 1) & (AY38910PSG_DCADJ_BUFLEN - 1);
-    return s - (c->dcadj_sum / AY38910PSG_DCADJ_BUFLEN);
+static resampler_level_t _ay38910psg_dcadjust(ay38910psg_t* c, resampler_level_t s) {
+#if RESAMPLER_FIXEDPOINT
+    c->dcadj_level += (s - c->dcadj_level) >> AY38910PSG_DCADJ_SHIFT;
+#else
+    c->dcadj_level += (s - c->dcadj_level) / (1 << AY38910PSG_DCADJ_SHIFT);
+#endif
+    return s - c->dcadj_level;
 }
 
 // update computed values after registers have been reprogrammed
@@ -359,7 +384,19 @@ void ay38910psg_init(ay38910psg_t* c, const ay38910psg_desc_t* desc) {
     c->user_data = desc->user_data;
     c->type = desc->type;
     c->noise.rng = 1;
+#if RESAMPLER_FIXEDPOINT
+    // the magnitude as 16.16 fixed point, the generators only mix integer levels
+    CHIPS_ASSERT((desc->magnitude >= 0.0f) && (desc->magnitude <= 1.0f));
+    const uint32_t mag = (uint32_t)(desc->magnitude * 65536.0f);
+    for (int i = 0; i < 16; i++) {
+        c->volumes[i] = (uint16_t)((_ay38910psg_volumes[i] * mag + 0x8000) >> 16);
+    }
+#else
     c->mag = desc->magnitude;
+#endif
+    if ((desc->tick_hz > 0) && (desc->sound_hz > 0)) {
+        resampler_init(&c->resampler, &(resampler_desc_t){.tick_hz = desc->tick_hz, .sound_hz = desc->sound_hz});
+    }
     _ay38910psg_update_values(c);
     _ay38910psg_restart_env_shape(c);
 }
@@ -417,25 +454,71 @@ void ay38910psg_tick_envelope_generator(ay38910psg_t* c) {
     }
 }
 
-void ay38910psg_tick_sample_generator(ay38910psg_t* c) {
-    float sm = 0.0f;
+static resampler_level_t _ay38910psg_sample(const ay38910psg_t* c) {
+    resampler_level_t sm = 0;
     for (int i = 0; i < AY38910PSG_NUM_CHANNELS; i++) {
         const ay38910psg_tone_t* chn = &c->tone[i];
-        int vol_enable = (chn->bit | chn->tone_disable) & ((c->noise.rng & 1) | (chn->noise_disable));
-        if (vol_enable) {
-            float vol;
-            if (0 == (c->reg[AY38910PSG_REG_AMP_A + i] & (1 << 4))) {
-                // fixed amplitude
-                vol = _ay38910psg_volumes[c->reg[AY38910PSG_REG_AMP_A + i] & 0x0F];
-            } else {
-                // envelope control
-                vol = _ay38910psg_volumes[c->env.shape_state];
-            }
-            sm += vol;
+        uint32_t vol_enable = (chn->bit | chn->tone_disable) & ((c->noise.rng & 1) | (chn->noise_disable));
+        uint8_t amp = c->reg[AY38910PSG_REG_AMP_A + i];
+        // fixed amplitude or envelope control
+        uint32_t level = (amp & (1 << 4)) ? c->env.shape_state : (amp & 0x0F);
+        // without branches, the output bits flip too irregularly to predict, a muted channel adds volume 0
+#if RESAMPLER_FIXEDPOINT
+        sm += c->volumes[level & (0 - vol_enable)];
+#else
+        sm += _ay38910psg_volumes[level & (0 - vol_enable)];
+#endif
+    }
+#if RESAMPLER_FIXEDPOINT
+    return sm;
+#else
+    return sm * c->mag;
+#endif
+}
+
+void ay38910psg_tick_sample_generator(ay38910psg_t* c) {
+    // c->sample = _ay38910psg_dcadjust(c, _ay38910psg_sample(c));
+    c->sample = _ay38910psg_sample(c);
+}
+
+// number of multiples of step (a power of 2) in the ticks [start, start + n)
+static uint32_t _ay38910psg_steps(uint32_t start, uint32_t n, uint32_t step) {
+    uint32_t first = ((start + step - 1) & ~(step - 1)) - start;
+    return (first < n) ? ((n - first - 1) / step + 1) : 0;
+}
+
+// run the generators over the ticks [c->tick, end_tick), they step on multiples of
+// AY38910PSG_CHANNEL_TICKS and AY38910PSG_ENVELOPE_TICKS like with per-tick calls
+static void _ay38910psg_advance(ay38910psg_t* c, uint32_t end_tick) {
+    uint32_t n = end_tick - c->tick;
+    for (uint32_t i = _ay38910psg_steps(c->tick, n, AY38910PSG_CHANNEL_TICKS); i > 0; i--) {
+        ay38910psg_tick_channels(c);
+    }
+    for (uint32_t i = _ay38910psg_steps(c->tick, n, AY38910PSG_ENVELOPE_TICKS); i > 0; i--) {
+        ay38910psg_tick_envelope_generator(c);
+    }
+    c->tick = end_tick;
+}
+
+int ay38910psg_render(ay38910psg_t* c, uint32_t end_tick, resampler_level_t* out, int max_samples) {
+    CHIPS_ASSERT(c && out && (max_samples > 0) && (c->resampler.step > 0));
+    int n = 0;
+    for (;;) {
+        // the output level only changes after a channel or envelope step, or a register write
+        n += resampler_render(&c->resampler, c->tick, &out[n], max_samples - n);
+        if (n == max_samples) {
+            break;
+        }
+        c->sample = _ay38910psg_sample(c);
+        resampler_set(&c->resampler, c->tick, c->sample);
+        if (c->tick == end_tick) {
+            break;
         }
+        // the envelope steps with every second channel step
+        uint32_t step_tick = (c->tick + AY38910PSG_CHANNEL_TICKS - 1) & ~(AY38910PSG_CHANNEL_TICKS - 1);
+        _ay38910psg_advance(c, ((int32_t)(end_tick - step_tick) > 0) ? (step_tick + 1) : end_tick);
     }
-    // c->sample = _ay38910psg_dcadjust(c, sm) * c->mag;
-    c->sample = sm * c->mag;
+    return n;
 }
 
 uint8_t ay38910psg_read(ay38910psg_t* c) {
@@ -4,6 +4,8 @@
 
     TODO: docs
 
+    Include chips/resampler.h before this file.
+
     ## zlib/libpng license
 
     Copyright (c) 2018 Andre Weissflog
@@ -31,8 +33,10 @@ extern "C" {
 
 // error-accumulation precision boost
 #define BEEPER_FIXEDPOINT_SCALE (16)
-// DC adjust buffer size
-#define BEEPER_DCADJ_BUFLEN (512)
+// DC adjust filter time constant, 1 << BEEPER_DCADJ_SHIFT samples
+#define BEEPER_DCADJ_SHIFT (9)
+// max number of toggles recorded between two beeper_flush() calls
+#define BEEPER_MAX_EVENTS (512)
 
 // initialization parameters
 typedef struct {
@@ -41,17 +45,25 @@ typedef struct {
     float base_volume;
 } beeper_desc_t;
 
-// beeper state
+// beeper state, levels have RESAMPLER_ONE as full scale
 typedef struct {
     int state;
     int period;
     int counter;
+#if RESAMPLER_FIXEDPOINT
+    int32_t base_volume;  // from beeper_desc_t
+    int32_t volume;       // 0 to 256, see beeper_set_volume()
+#else
     float base_volume;
     float volume;
-    float sample;
-    float dcadj_sum;
-    uint32_t dcadj_pos;
-    float dcadj_buf[BEEPER_DCADJ_BUFLEN];
+#endif
+    resampler_level_t sample;
+    resampler_level_t dcadj_level;  // average level removed by the DC adjust filter
+
+    // event mode, see beeper_toggle_at() and beeper_flush()
+    resampler_t resampler;  // band-limited speaker state
+    int num_events;
+    uint32_t events[BEEPER_MAX_EVENTS];  // ticks of the toggles since the last flush
 } beeper_t;
 
 // initialize beeper instance
@@ -63,9 +75,20 @@ static inline void beeper_set(beeper_t* beeper, bool state) { beeper->state = st
 // toggle current state (on->off or off->on)
 static inline void beeper_toggle(beeper_t* beeper) { beeper->state = !beeper->state; }
 // set current volume 0.0 to 1.0
-static inline void beeper_set_volume(beeper_t* beeper, float vol) { beeper->volume = vol; }
+static inline void beeper_set_volume(beeper_t* beeper, float vol) {
+#if RESAMPLER_FIXEDPOINT
+    beeper->volume = (int32_t)(vol * 256.0f);
+#else
+    beeper->volume = vol;
+#endif
+}
 // tick the beeper, return true if a new sample is ready
 bool beeper_tick(beeper_t* beeper);
+// toggle current state at the given tick, instead of ticking the beeper every cycle
+void beeper_toggle_at(beeper_t* beeper, uint32_t tick);
+// synthesize the samples up to end_tick from the recorded toggles, return the number written to out,
+// call again with the same end_tick while it returns max_samples
+int beeper_flush(beeper_t* beeper, uint32_t end_tick, resampler_level_t* out, int max_samples);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -84,9 +107,15 @@ void beeper_init(beeper_t* b, const beeper_desc_t* desc) {
     *b = (beeper_t){
         .period = (desc->tick_hz * BEEPER_FIXEDPOINT_SCALE) / desc->sound_hz,
         .counter = b->period,
+#if RESAMPLER_FIXEDPOINT
+        .base_volume = (int32_t)(desc->base_volume * RESAMPLER_ONE),
+        .volume = 256,
+#else
         .base_volume = desc->base_volume,
         .volume = 1.0f,
+#endif
     };
+    resampler_init(&b->resampler, &(resampler_desc_t){.tick_hz = desc->tick_hz, .sound_hz = desc->sound_hz});
 }
 
 void beeper_reset(beeper_t* b) {
@@ -94,19 +123,32 @@ void beeper_reset(beeper_t* b) {
     b->state = 0;
     b->counter = b->period;
     b->sample = 0;
+    b->num_events = 0;
+    resampler_reset(&b->resampler);
 }
 
-/* DC adjustment filter from StSound, this moves an "offcenter"
-   signal back to the zero-line (e.g. the volume-level output
-   from the chip simulation which is >0.0 gets converted to
-   a +/- sample value)
+/* DC adjustment filter, this moves an "offcenter" signal back
+   to the zero-line (e.g. the volume-level output from the chip
+   simulation which is >0 gets converted to a +/- sample value),
+   the average is a one-pole lowpass instead of StSound's moving
+   average, so no sample history is kept
 */
-static float _beeper_dcadjust(beeper_t* bp, float s) {
-    bp->dcadj_sum -= bp->dcadj_buf[bp->dcadj_pos];
-    bp->dcadj_sum += s;
-    bp->dcadj_buf[bp->dcadj_pos] = s;
-    bp->dcadj_pos = (bp->dcadj_pos + 1) & (BEEPER_DCADJ_BUFLEN - 1);
-    return s - (bp->dcadj_sum / BEEPER_DCADJ_BUFLEN);
+static resampler_level_t _beeper_dcadjust(beeper_t* bp, resampler_level_t s) {
+#if RESAMPLER_FIXEDPOINT
+    bp->dcadj_level += (s - bp->dcadj_level) >> BEEPER_DCADJ_SHIFT;
+#else
+    bp->dcadj_level += (s - bp->dcadj_level) / (1 << BEEPER_DCADJ_SHIFT);
+#endif
+    return s - bp->dcadj_level;
+}
+
+// the speaker level at full volume
+static inline resampler_level_t _beeper_amplitude(const beeper_t* bp) {
+#if RESAMPLER_FIXEDPOINT
+    return (bp->base_volume * bp->volume) >> 8;
+#else
+    return bp->volume * bp->base_volume;
+#endif
 }
 
 bool beeper_tick(beeper_t* bp) {
@@ -114,11 +156,56 @@ bool beeper_tick(beeper_t* bp) {
     bp->counter -= BEEPER_FIXEDPOINT_SCALE;
     if (bp->counter <= 0) {
         bp->counter += bp->period;
-        // bp->sample = _beeper_dcadjust(bp, (float)bp->state * bp->volume * bp->base_volume);
-        bp->sample = (float)bp->state * bp->volume * bp->base_volume;
+        // bp->sample = _beeper_dcadjust(bp, bp->state ? _beeper_amplitude(bp) : 0);
+        bp->sample = bp->state ? _beeper_amplitude(bp) : 0;
         return true;
     }
     return false;
 }
 
+void beeper_toggle_at(beeper_t* bp, uint32_t tick) {
+    bp->state = !bp->state;
+    if (bp->num_events < BEEPER_MAX_EVENTS) {
+        bp->events[bp->num_events++] = tick;
+    } else {
+        // out of room until the next flush, cancel the previous toggle so the level stays right
+        bp->num_events--;
+    }
+}
+
+int beeper_flush(beeper_t* bp, uint32_t end_tick, resampler_level_t* out, int max_samples) {
+    CHIPS_ASSERT(bp && out && (max_samples > 0));
+    // speaker state before the first recorded toggle, each toggle flips it
+    int state = (bp->state != 0) ^ (bp->num_events & 1);
+#if RESAMPLER_FIXEDPOINT
+    // the volume is part of the levels, no per-sample scaling
+    const int32_t amplitude = _beeper_amplitude(bp);
+#else
+    // unit steps, the volume is applied to the rendered samples
+    const float amplitude = 1.0f;
+#endif
+    int ev = 0;
+    int n = 0;
+    for (; ev < bp->num_events; ev++) {
+        n += resampler_render(&bp->resampler, bp->events[ev], &out[n], max_samples - n);
+        if (n == max_samples) {
+            break;
+        }
+        state = !state;
+        resampler_set(&bp->resampler, bp->events[ev], state ? amplitude : 0);
+    }
+    if (n < max_samples) {
+        n += resampler_render(&bp->resampler, end_tick, &out[n], max_samples - n);
+    }
+#if !RESAMPLER_FIXEDPOINT
+    const float volume = _beeper_amplitude(bp);
+    for (int i = 0; i < n; i++) {
+        out[i] *= volume;
+    }
+#endif
+    bp->num_events -= ev;
+    memmove(bp->events, &bp->events[ev], bp->num_events * sizeof(uint32_t));
+    return n;
+}
+
 #endif /* CHIPS_IMPL */
@@ -47,6 +47,55 @@ typedef struct {
     int x, y, width, height;
 } chips_rect_t;
 
+// Bit mask of framebuffer rows rewritten by a renderer, one bit per row
+#define CHIPS_FB_DIRTY_WORDS(height) (((height) + 31) / 32)
+
+static inline void chips_fb_dirty_set(uint32_t* rows, int y) { rows[y >> 5] |= 1u << (y & 31); }
+
+static inline bool chips_fb_dirty_test(const uint32_t* rows, int y) { return (rows[y >> 5] >> (y & 31)) & 1; }
+
+// Text screen decoded from video memory, see the systems' *_text_screen() functions
+#define CHIPS_TEXT_MAX_COLUMNS (80)
+#define CHIPS_TEXT_MAX_ROWS    (28)
+
+#define CHIPS_TEXT_INVERSE (1 << 0)
+#define CHIPS_TEXT_FLASH   (1 << 1)
+#define CHIPS_TEXT_DOUBLE  (1 << 2)  // Double height
+#define CHIPS_TEXT_ALT     (1 << 3)  // Alternate charset glyph (Oric mosaics, //e MouseText)
+
+typedef struct {
+    int columns;
+    int rows;
+    int first_row;                                                // Rows above show graphics and are blank
+    char chars[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];      // ASCII
+    uint8_t attrs[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];   // CHIPS_TEXT_* flags
+    uint8_t colors[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];  // Foreground in bits 0..3, background in 4..7
+} chips_text_screen_t;
+
+// Range of consecutive dirty framebuffer rows [y, y + height)
+typedef struct {
+    int y, height;
+} chips_fb_span_t;
+
+// Collect the runs of dirty rows into spans, return the number of spans written, when there are more runs than
+// max_spans the last span is extended over the remaining dirty rows (and the clean rows between them)
+static inline int chips_fb_dirty_spans(const uint32_t* rows, int height, chips_fb_span_t* spans, int max_spans) {
+    int num_spans = 0;
+    for (int y = 0; y < height; y++) {
+        if (!chips_fb_dirty_test(rows, y)) {
+            continue;
+        }
+        if ((num_spans > 0) && (spans[num_spans - 1].y + spans[num_spans - 1].height == y)) {
+            spans[num_spans - 1].height++;
+        } else if (num_spans < max_spans) {
+            spans[num_spans++] = (chips_fb_span_t){y, 1};
+        } else if (num_spans > 0) {
+            spans[num_spans - 1].height = y + 1 - spans[num_spans - 1].y;
+        }
+    }
+    return num_spans;
+}
+
 typedef struct {
     struct {
         chips_dim_t dim;  // framebuffer dimensions in pixels
@@ -58,6 +107,7 @@ typedef struct {
     bool portrait;
 } chips_display_info_t;
 
+// samples are only valid during the call, the system refills its buffer afterwards
 typedef struct {
     void (*func)(const uint8_t* samples, int num_samples, void* user_data);
     void* user_data;
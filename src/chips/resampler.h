@@ -0,0 +1,299 @@
+#pragma once
+/*
+    resampler.h -- band-limited resampler for step-wise chip outputs
+
+    Do this:
+        #define CHIPS_IMPL
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    CHIPS_ASSERT(c)     -- your own assert macro (default: assert(c))
+
+    Sound chips like the beeper and the AY-3-8910 output a level that only
+    changes at discrete ticks of their input clock. Instead of point-sampling
+    that level at the host rate, which aliases, every level change is added to
+    the output as a band-limited step (a windowed sinc impulse integrated over
+    time). The impulses come from a polyphase table with BLEP_PHASES sub-sample
+    positions, so any output rate works, 22050, 44100 and 48000 Hz alike.
+
+    Level changes must be passed in time order, and only once all samples up
+    to their tick have been rendered:
+
+        n += resampler_render(&rs, tick, out + n, max - n);   // until it returns less than max
+        resampler_set(&rs, tick, level);
+
+    The output lags the input by RESAMPLER_BLEP_TAPS / 2 samples.
+
+    Levels are resampler_level_t, RESAMPLER_ONE is full scale. They are
+    floats by default. Define RESAMPLER_FIXEDPOINT as 1 (the Pico builds do)
+    for integer levels, so no float math runs on CPUs without an FPU. The
+    integer steps are stored integrated, each tap adds the difference of two
+    rounded step values, so a step always adds up to exactly its height and
+    the rounding can't accumulate. The two paths differ in the last bits,
+    each gives the same samples on every host.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// band-limited step kernel length in samples, and number of sub-sample phases
+#define RESAMPLER_BLEP_TAPS       (16)
+#define RESAMPLER_BLEP_PHASE_BITS (5)
+#define RESAMPLER_BLEP_PHASES     (1 << RESAMPLER_BLEP_PHASE_BITS)
+// pending band-limited step contributions, power of 2 larger than RESAMPLER_BLEP_TAPS
+#define RESAMPLER_BLEP_RING (32)
+
+#ifndef RESAMPLER_FIXEDPOINT
+#define RESAMPLER_FIXEDPOINT (0)
+#endif
+
+#if RESAMPLER_FIXEDPOINT
+// fractional bits of the band-limited step table
+#define RESAMPLER_BLEP_BITS (14)
+// level of a full scale output, and the input level range that keeps the steps from overflowing
+#define RESAMPLER_ONE_BITS  (14)
+#define RESAMPLER_ONE       (1 << RESAMPLER_ONE_BITS)
+#define RESAMPLER_MAX_LEVEL (3 * RESAMPLER_ONE)
+// a constant level, x is a compile-time float constant
+#define RESAMPLER_LEVEL(x) ((int32_t)((x) * RESAMPLER_ONE))
+typedef int32_t resampler_level_t;
+#else
+#define RESAMPLER_ONE      (1.0f)
+#define RESAMPLER_LEVEL(x) (x)
+typedef float resampler_level_t;
+#endif
+
+// initialization parameters
+typedef struct {
+    int tick_hz;   // input clock frequency
+    int sound_hz;  // output sample rate
+} resampler_desc_t;
+
+// resampler state
+typedef struct {
+    uint32_t tick;         // tick of the last completed render
+    uint64_t time;         // sample time at tick, 32.32 fixed point
+    uint64_t step;         // samples per tick, 32.32 fixed point
+    uint64_t base_step;    // step without rate adjustment
+    uint64_t next_sample;  // sample time of the next output sample, 32.32 fixed point
+#if !RESAMPLER_FIXEDPOINT
+    uint64_t settled;  // sample time after which no step adds to the output anymore
+#endif
+    resampler_level_t target;  // input level after the last change
+    resampler_level_t level;   // integrated band-limited output level
+    resampler_level_t ring[RESAMPLER_BLEP_RING];
+} resampler_t;
+
+// initialize a resampler instance
+void resampler_init(resampler_t* rs, const resampler_desc_t* desc);
+// reset the output to level 0 at the current position
+void resampler_reset(resampler_t* rs);
+// change the input level at the given tick, samples up to tick must have been rendered
+void resampler_set(resampler_t* rs, uint32_t tick, resampler_level_t level);
+// render the samples up to end_tick, return the number written to out,
+// call again with the same end_tick while it returns max_samples
+int resampler_render(resampler_t* rs, uint32_t end_tick, resampler_level_t* out, int max_samples);
+// speed the output rate up or slow it down by ppm parts per million, to follow a drifting audio clock,
+// call between complete renders
+void resampler_set_rate_adjust(resampler_t* rs, int32_t ppm);
+// scale a level by another, RESAMPLER_ONE leaves it unchanged
+static inline resampler_level_t resampler_mul(resampler_level_t a, resampler_level_t b) {
+#if RESAMPLER_FIXEDPOINT
+    return (a * b) >> RESAMPLER_ONE_BITS;
+#else
+    return a * b;
+#endif
+}
+// convert an output level to an unsigned 8-bit sample, 0 to RESAMPLER_ONE maps to 0 to 255
+static inline uint8_t resampler_to_u8(resampler_level_t level) {
+#if RESAMPLER_FIXEDPOINT
+    return (level <= 0) ? 0 : (level >= RESAMPLER_ONE) ? 255 : (uint8_t)((level * 255) >> RESAMPLER_ONE_BITS);
+#else
+    return (uint8_t)((level < 0.0f) ? 0 : (level > 1.0f) ? 255 : level * 255.0f);
+#endif
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+#if RESAMPLER_FIXEDPOINT
+#ifndef __not_in_flash
+#define __not_in_flash(group)  // Pico SDK RAM placement, nothing to do on hosts
+#endif
+
+// Band-limited steps at each sub-sample phase, shared by all resamplers: windowed sinc
+// impulses (Blackman window, cutoff at 0.9 of the Nyquist frequency) normalized to 1,
+// integrated and scaled by 1 << RESAMPLER_BLEP_BITS. A precomputed table, so hosts and
+// microcontrollers with different libm's render the same samples. Read for every output
+// sample, so it is kept in RAM on the Pico.
+static int16_t __not_in_flash() _resampler_blep[RESAMPLER_BLEP_PHASES][RESAMPLER_BLEP_TAPS] = {
+    {9, -46, 133, -288, 492, -694, 819, 15565, 17078, 15892, 16672, 16251, 16430, 16375, 16384, 16384},
+    {9, -45, 128, -269, 441, -572, 487, 15213, 17200, 15843, 16689, 16246, 16431, 16375, 16384, 16384},
+    {8, -44, 122, -249, 389, -451, 175, 14841, 17321, 15796, 16705, 16243, 16431, 16375, 16384, 16384},
+    {8, -43, 115, -228, 336, -332, -115, 14451, 17441, 15752, 16718, 16240, 16430, 16376, 16384, 16384},
+    {8, -41, 107, -206, 282, -216, -384, 14043, 17558, 15712, 16730, 16239, 16429, 16376, 16384, 16384},
+    {7, -39, 99, -184, 229, -104, -631, 13618, 17671, 15675, 16739, 16239, 16428, 16377, 16384, 16384},
+    {7, -37, 91, -160, 176, 4, -857, 13178, 17779, 15643, 16745, 16240, 16426, 16378, 16384, 16384},
+    {6, -35, 82, -137, 124, 107, -1060, 12722, 17881, 15615, 16748, 16243, 16424, 16379, 16384, 16384},
+    {6, -32, 74, -114, 73, 204, -1242, 12254, 17976, 15593, 16749, 16247, 16421, 16380, 16384, 16384},
+    {5, -30, 65, -91, 24, 295, -1402, 11773, 18062, 15577, 16746, 16253, 16418, 16381, 16384, 16384},
+    {5, -27, 56, -68, -23, 380, -1540, 11282, 18138, 15566, 16741, 16260, 16414, 16383, 16384, 16384},
+    {4, -24, 47, -46, -68, 458, -1658, 10782, 18204, 15562, 16731, 16268, 16409, 16384, 16384, 16384},
+    {4, -21, 38, -25, -110, 528, -1755, 10273, 18258, 15565, 16719, 16278, 16404, 16386, 16383, 16384},
+    {3, -19, 29, -4, -150, 591, -1832, 9758, 18299, 15575, 16703, 16290, 16398, 16388, 16383, 16384},
+    {3, -16, 21, 15, -186, 647, -1889, 9239, 18326, 15592, 16683, 16303, 16392, 16390, 16383, 16384},
+    {2, -13, 13, 33, -220, 695, -1928, 8716, 18338, 15617, 16660, 16317, 16386, 16393, 16383, 16384},
+    {2, -11, 6, 51, -249, 735, -1949, 8192, 18333, 15649, 16633, 16333, 16378, 16395, 16382, 16384},
+    {1, -9, -2, 67, -276, 767, -1954, 7668, 18312, 15689, 16604, 16351, 16371, 16397, 16382, 16384},
+    {1, -6, -8, 81, -299, 792, -1942, 7145, 18273, 15737, 16570, 16369, 16363, 16400, 16381, 16384},
+    {1, -4, -14, 94, -319, 809, -1915, 6626, 18216, 15793, 16534, 16388, 16355, 16403, 16381, 16384},
+    {1, -2, -20, 106, -335, 819, -1874, 6111, 18139, 15856, 16494, 16409, 16346, 16405, 16380, 16384},
+    {0, 0, -25, 116, -347, 822, -1820, 5602, 18042, 15926, 16452, 16430, 16337, 16408, 16380, 16384},
+    {0, 1, -30, 124, -357, 818, -1754, 5102, 17924, 16004, 16407, 16452, 16328, 16411, 16379, 16384},
+    {0, 3, -34, 131, -362, 807, -1678, 4611, 17786, 16089, 16360, 16475, 16319, 16414, 16379, 16384},
+    {0, 4, -37, 137, -365, 791, -1592, 4130, 17626, 16180, 16311, 16498, 16310, 16416, 16378, 16384},
+    {0, 5, -40, 141, -364, 769, -1497, 3662, 17444, 16277, 16260, 16521, 16302, 16419, 16378, 16384},
+    {0, 6, -42, 144, -361, 741, -1395, 3206, 17241, 16380, 16208, 16544, 16293, 16421, 16377, 16384},
+    {0, 7, -44, 145, -355, 709, -1287, 2766, 17015, 16488, 16155, 16568, 16285, 16423, 16377, 16384},
+    {0, 8, -45, 145, -346, 672, -1174, 2341, 16768, 16600, 16102, 16590, 16277, 16425, 16376, 16384},
+    {0, 8, -46, 144, -334, 632, -1057, 1933, 16499, 16716, 16048, 16612, 16269, 16427, 16376, 16384},
+    {0, 9, -47, 141, -321, 588, -937, 1543, 16209, 16835, 15995, 16633, 16262, 16428, 16376, 16384},
+    {0, 9, -47, 138, -305, 541, -816, 1171, 15897, 16956, 15943, 16653, 16256, 16429, 16375, 16384},
+};
+#else
+#include <math.h>
+
+// Windowed sinc impulses at each sub-sample phase, shared by all resamplers. A level
+// change adds one as the derivative of a band-limited step, the output integrates them.
+static float _resampler_blep[RESAMPLER_BLEP_PHASES][RESAMPLER_BLEP_TAPS];
+static bool _resampler_blep_valid;
+
+static void _resampler_init_blep(void) {
+    const float pi = 3.14159265f;
+    const float cutoff = 0.9f;  // of the Nyquist frequency
+    const float half = RESAMPLER_BLEP_TAPS / 2;
+    for (int p = 0; p < RESAMPLER_BLEP_PHASES; p++) {
+        float sum = 0.0f;
+        for (int i = 0; i < RESAMPLER_BLEP_TAPS; i++) {
+            // distance of tap i from the step, which is centered half a kernel later
+            float x = (float)(i + 1) - (float)p / RESAMPLER_BLEP_PHASES - half;
+            float sinc = (x == 0.0f) ? 1.0f : sinf(pi * cutoff * x) / (pi * cutoff * x);
+            float window =
+                (fabsf(x) >= half) ? 0.0f : 0.42f + 0.5f * cosf(pi * x / half) + 0.08f * cosf(2 * pi * x / half);
+            _resampler_blep[p][i] = sinc * window;
+            sum += _resampler_blep[p][i];
+        }
+        // every step settles at exactly its height
+        for (int i = 0; i < RESAMPLER_BLEP_TAPS; i++) {
+            _resampler_blep[p][i] /= sum;
+        }
+    }
+    _resampler_blep_valid = true;
+}
+#endif
+
+void resampler_init(resampler_t* rs, const resampler_desc_t* desc) {
+    CHIPS_ASSERT(rs && desc);
+    CHIPS_ASSERT((desc->tick_hz > 0) && (desc->sound_hz > 0));
+    memset(rs, 0, sizeof(resampler_t));
+    rs->base_step = ((uint64_t)desc->sound_hz << 32) / (uint64_t)desc->tick_hz;
+    rs->step = rs->base_step;
+#if !RESAMPLER_FIXEDPOINT
+    if (!_resampler_blep_valid) {
+        _resampler_init_blep();
+    }
+#endif
+}
+
+void resampler_reset(resampler_t* rs) {
+    CHIPS_ASSERT(rs);
+    rs->target = 0;
+    rs->level = 0;
+#if !RESAMPLER_FIXEDPOINT
+    rs->settled = rs->next_sample;
+#endif
+    memset(rs->ring, 0, sizeof(rs->ring));
+}
+
+static inline uint64_t _resampler_time(const resampler_t* rs, uint32_t tick) {
+    return rs->time + (uint64_t)(uint32_t)(tick - rs->tick) * rs->step;
+}
+
+void resampler_set(resampler_t* rs, uint32_t tick, resampler_level_t level) {
+#if RESAMPLER_FIXEDPOINT
+    CHIPS_ASSERT(rs && (level >= -RESAMPLER_MAX_LEVEL) && (level <= RESAMPLER_MAX_LEVEL));
+#else
+    CHIPS_ASSERT(rs);
+#endif
+    if (level == rs->target) {
+        return;
+    }
+    // add a band-limited step of the level difference at sample time t
+    const uint64_t t = _resampler_time(rs, tick);
+    CHIPS_ASSERT((int64_t)(t - rs->next_sample) < 0);
+    const resampler_level_t delta = level - rs->target;
+    uint32_t index = (uint32_t)(t >> 32) + 1;
+    const uint32_t phase = (t >> (32 - RESAMPLER_BLEP_PHASE_BITS)) & (RESAMPLER_BLEP_PHASES - 1);
+#if RESAMPLER_FIXEDPOINT
+    const int16_t* blep = _resampler_blep[phase];
+    int32_t prev = 0;
+    for (int i = 0; i < RESAMPLER_BLEP_TAPS; i++) {
+        const int32_t cur = (blep[i] * delta) >> RESAMPLER_BLEP_BITS;
+        rs->ring[(index + i) & (RESAMPLER_BLEP_RING - 1)] += cur - prev;
+        prev = cur;
+    }
+#else
+    const float* blep = _resampler_blep[phase];
+    for (int i = 0; i < RESAMPLER_BLEP_TAPS; i++) {
+        rs->ring[(index + i) & (RESAMPLER_BLEP_RING - 1)] += blep[i] * delta;
+    }
+    rs->settled = (uint64_t)(index + RESAMPLER_BLEP_TAPS) << 32;
+#endif
+    rs->target = level;
+}
+
+int resampler_render(resampler_t* rs, uint32_t end_tick, resampler_level_t* out, int max_samples) {
+    CHIPS_ASSERT(rs && out && (max_samples >= 0));
+    const uint64_t end_time = _resampler_time(rs, end_tick);
+    int n = 0;
+    // a sample only gets steps from before it, so every sample up to end_time is final
+    while ((n < max_samples) && ((int64_t)(rs->next_sample - end_time) <= 0)) {
+        resampler_level_t* slot = &rs->ring[(rs->next_sample >> 32) & (RESAMPLER_BLEP_RING - 1)];
+        rs->level += *slot;
+        *slot = 0;
+#if !RESAMPLER_FIXEDPOINT
+        if ((int64_t)(rs->next_sample - rs->settled) >= 0) {
+            // all steps have settled, drop the accumulated rounding error
+            rs->level = rs->target;
+        }
+#endif
+        out[n++] = rs->level;
+        rs->next_sample += (uint64_t)1 << 32;
+    }
+    if ((int64_t)(rs->next_sample - end_time) > 0) {
+        // all samples up to end_tick are out, later changes are relative to it
+        rs->tick = end_tick;
+        rs->time = end_time;
+    }
+    return n;
+}
+
+void resampler_set_rate_adjust(resampler_t* rs, int32_t ppm) {
+    CHIPS_ASSERT(rs && (ppm > -1000000) && (ppm < 1000000));
+    rs->step = rs->base_step + (uint64_t)(((int64_t)rs->base_step * ppm) / 1000000);
+}
+
+#endif /* CHIPS_IMPL */
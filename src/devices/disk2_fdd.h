@@ -11,6 +11,16 @@
 extern "C" {
 #endif
 
+// Disk II floppy disk drive
+//
+// Reads NIB images, or 143,360 byte sector images (DSK, DO, PO) which are
+// nibblized with devices/disk2_nib.h one track at a time: the track under
+// the head is encoded into a one track cache by the first read after the
+// head moved to it, so each byte read stays a lookup and tracks passed
+// over while seeking are never encoded. Sector images are read only.
+//
+// Include devices/disk2_nib.h before this file.
+
 #define DISK2_FDD_TRACKS_PER_DISK   35
 #define DISK2_FDD_SECTORS_PER_TRACK 16
 #define DISK2_FDD_BYTES_PER_SECTOR  256
@@ -35,6 +45,10 @@ typedef struct {
     uint8_t write_ready;
     int nib_image_offset;
     uint8_t* nib_image;
+    const uint8_t* dsk_image;                            // Sector image, or NULL for a NIB image
+    disk2_nib_order_t dsk_order;                         // Sector order of dsk_image
+    int cached_track;                                    // Track in track_cache, -1 if none
+    uint8_t track_cache[DISK2_FDD_BYTES_PER_NIB_TRACK];  // Nibblized track of dsk_image
 } disk2_fdd_t;
 
 // Disk II floppy disk drive interface
@@ -53,6 +67,9 @@ void disk2_fdd_tick(disk2_fdd_t* sys);
 // Insert a new disk file
 bool disk2_fdd_insert_disk(disk2_fdd_t* sys, uint8_t* nib_image);
 
+// Insert a DISK2_FDD_DSK_IMAGE_SIZE byte sector image, nibblized a track at a time while reading
+bool disk2_fdd_insert_dsk(disk2_fdd_t* sys, const uint8_t* dsk_image, disk2_nib_order_t order);
+
 // Remove the disk file
 void disk2_fdd_remove_disk(disk2_fdd_t* sys);
 
@@ -118,6 +135,20 @@ bool disk2_fdd_insert_disk(disk2_fdd_t* sys, uint8_t* nib_image) {
     CHIPS_ASSERT(sys && sys->valid);
     sys->nib_image_offset = 0;
     sys->nib_image = nib_image;
+    sys->dsk_image = NULL;
+    sys->nib_image_loaded = true;
+    return true;
+}
+
+bool disk2_fdd_insert_dsk(disk2_fdd_t* sys, const uint8_t* dsk_image, disk2_nib_order_t order) {
+    CHIPS_ASSERT(sys && sys->valid && dsk_image);
+    sys->nib_image_offset = 0;
+    sys->nib_image = NULL;
+    sys->dsk_image = dsk_image;
+    sys->dsk_order = order;
+    sys->cached_track = -1;
+    // Writes would only change the cached track
+    sys->write_protected = true;
     sys->nib_image_loaded = true;
     return true;
 }
@@ -126,6 +157,7 @@ void disk2_fdd_remove_disk(disk2_fdd_t* sys) {
     CHIPS_ASSERT(sys && sys->valid);
     sys->nib_image_loaded = false;
     sys->image_dirty = false;
+    sys->dsk_image = NULL;
 }
 
 bool disk2_fdd_is_disk_inserted(disk2_fdd_t* sys) {
@@ -155,6 +187,20 @@ static void _disk2_fdd_update_offset(disk2_fdd_t* sys) {
     }
 }
 
+// Return the nibbles of the track under the head, a sector image track is encoded on the first access
+static uint8_t* _disk2_fdd_track(disk2_fdd_t* sys) {
+    const int track = sys->half_track / 2;
+    if (!sys->dsk_image) {
+        return sys->nib_image + track * DISK2_FDD_BYTES_PER_NIB_TRACK;
+    }
+    if (sys->cached_track != track) {
+        disk2_nib_encode_track(sys->track_cache, sys->dsk_image + track * DISK2_FDD_BYTES_PER_TRACK, (uint8_t)track,
+                               DISK2_NIB_DEFAULT_VOLUME, sys->dsk_order);
+        sys->cached_track = track;
+    }
+    return sys->track_cache;
+}
+
 uint8_t disk2_fdd_read_byte(disk2_fdd_t* sys) {
     CHIPS_ASSERT(sys && sys->valid);
     sys->write_ready = 0x80;
@@ -164,7 +210,7 @@ uint8_t disk2_fdd_read_byte(disk2_fdd_t* sys) {
                 return 0xFF;
             }
             _disk2_fdd_update_offset(sys);
-            return *(sys->nib_image + (sys->half_track / 2) * DISK2_FDD_BYTES_PER_NIB_TRACK + sys->offset);
+            return _disk2_fdd_track(sys)[sys->offset];
 
         case 1:
             return sys->write_protected | sys->motor_state;
@@ -180,7 +226,7 @@ uint8_t disk2_fdd_read_byte(disk2_fdd_t* sys) {
 void disk2_fdd_write_byte(disk2_fdd_t* sys, uint8_t byte) {
     CHIPS_ASSERT(sys && sys->valid);
 
-    if (!sys->nib_image_loaded || sys->write_protected || byte < 0x96) {
+    if (!sys->nib_image_loaded || sys->write_protected || sys->dsk_image || byte < 0x96) {
         return;
     }
 
@@ -188,7 +234,7 @@ void disk2_fdd_write_byte(disk2_fdd_t* sys, uint8_t byte) {
         printf("disk2_fdd_write_byte: offset=%d, byte=%02x\n", sys->offset, byte);
 
         _disk2_fdd_update_offset(sys);
-        *(sys->nib_image + (sys->half_track / 2) * DISK2_FDD_BYTES_PER_NIB_TRACK + sys->offset) = byte;
+        _disk2_fdd_track(sys)[sys->offset] = byte;
         sys->image_dirty = true;
         sys->write_ready = 0;
     }
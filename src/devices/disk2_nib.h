@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Disk II 6-and-2 track encoder
+//
+// Turns the 16 sectors of a track of a 143,360 byte sector image (DSK, DO
+// or PO) into the 5,984 byte nibble stream of a NIB image track, the same
+// layout dsk2nib writes: per sector a gap, the address field, a gap and
+// the 6-and-2 encoded data field.
+
+#define DISK2_NIB_TRACKS_PER_DISK   35
+#define DISK2_NIB_SECTORS_PER_TRACK 16
+#define DISK2_NIB_BYTES_PER_SECTOR  256
+#define DISK2_NIB_BYTES_PER_TRACK   (DISK2_NIB_SECTORS_PER_TRACK * DISK2_NIB_BYTES_PER_SECTOR)
+#define DISK2_NIB_DSK_IMAGE_SIZE    (DISK2_NIB_TRACKS_PER_DISK * DISK2_NIB_BYTES_PER_TRACK)
+
+#define DISK2_NIB_BYTES_PER_NIB_SECTOR 374
+#define DISK2_NIB_BYTES_PER_NIB_TRACK  (DISK2_NIB_SECTORS_PER_TRACK * DISK2_NIB_BYTES_PER_NIB_SECTOR)
+#define DISK2_NIB_NIB_IMAGE_SIZE       (DISK2_NIB_TRACKS_PER_DISK * DISK2_NIB_BYTES_PER_NIB_TRACK)
+
+#define DISK2_NIB_DEFAULT_VOLUME 254
+
+// Sector order of a sector image
+typedef enum {
+    DISK2_NIB_ORDER_DOS = 0,  // DOS 3.3 order (DSK, DO)
+    DISK2_NIB_ORDER_PRODOS,   // ProDOS order (PO)
+} disk2_nib_order_t;
+
+// Sector image embedded in an images header, see README.md
+typedef struct {
+    const uint8_t* image;  // DISK2_NIB_DSK_IMAGE_SIZE bytes
+    disk2_nib_order_t order;
+} disk2_nib_dsk_image_t;
+
+// Encode one track, dsk_track points at the DISK2_NIB_BYTES_PER_TRACK bytes of the track in the sector image,
+// nib_track receives DISK2_NIB_BYTES_PER_NIB_TRACK bytes
+void disk2_nib_encode_track(uint8_t* nib_track, const uint8_t* dsk_track, uint8_t track, uint8_t volume,
+                            disk2_nib_order_t order);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _DISK2_NIB_PRIMARY_LEN   256
+#define _DISK2_NIB_SECONDARY_LEN 86
+#define _DISK2_NIB_GAP1_LEN      6
+#define _DISK2_NIB_GAP2_LEN      5
+#define _DISK2_NIB_GAP_BYTE      0xFF
+
+static const uint8_t _disk2_nib_addr_prolog[3] = {0xD5, 0xAA, 0x96};
+static const uint8_t _disk2_nib_data_prolog[3] = {0xD5, 0xAA, 0xAD};
+static const uint8_t _disk2_nib_epilog[3] = {0xDE, 0xAA, 0xEB};
+
+// Image sector and physical position on the track of each address field sector number
+// clang-format off
+static const uint8_t _disk2_nib_soft_interleave[2][DISK2_NIB_SECTORS_PER_TRACK] = {
+    {0, 7, 0xE, 6, 0xD, 5, 0xC, 4, 0xB, 3, 0xA, 2, 9, 1, 8, 0xF},
+    {0, 8, 1, 9, 2, 0xA, 3, 0xB, 4, 0xC, 5, 0xD, 6, 0xE, 7, 0xF},
+};
+static const uint8_t _disk2_nib_phys_interleave[2][DISK2_NIB_SECTORS_PER_TRACK] = {
+    {0, 0xD, 0xB, 9, 7, 5, 3, 1, 0xE, 0xC, 0xA, 8, 6, 4, 2, 0xF},
+    {0, 2, 4, 6, 8, 0xA, 0xC, 0xE, 1, 3, 5, 7, 9, 0xB, 0xD, 0xF},
+};
+// clang-format on
+
+// 6-bit values to disk nibbles
+// clang-format off
+static const uint8_t _disk2_nib_translate[0x40] = {
+    0x96, 0x97, 0x9A, 0x9B, 0x9D, 0x9E, 0x9F, 0xA6,
+    0xA7, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB2, 0xB3,
+    0xB4, 0xB5, 0xB6, 0xB7, 0xB9, 0xBA, 0xBB, 0xBC,
+    0xBD, 0xBE, 0xBF, 0xCB, 0xCD, 0xCE, 0xCF, 0xD3,
+    0xD6, 0xD7, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE,
+    0xDF, 0xE5, 0xE6, 0xE7, 0xE9, 0xEA, 0xEB, 0xEC,
+    0xED, 0xEE, 0xEF, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6,
+    0xF7, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
+};
+// clang-format on
+
+// Encode 1 byte into two "4 and 4" bytes
+static uint8_t* _disk2_nib_odd_even(uint8_t* dst, uint8_t byte) {
+    dst[0] = ((byte >> 1) & 0x55) | 0xAA;
+    dst[1] = (byte & 0x55) | 0xAA;
+    return dst + 2;
+}
+
+// Convert 256 data bytes into 342 6-and-2 encoded bytes and a checksum, return the end of the output
+static uint8_t* _disk2_nib_encode_data(uint8_t* dst, const uint8_t* src) {
+    uint8_t secondary[_DISK2_NIB_SECONDARY_LEN] = {0};
+    for (int i = 0; i < _DISK2_NIB_PRIMARY_LEN; i++) {
+        // The low two bits go swapped into the secondary buffer
+        uint8_t pair = ((src[i] & 2) >> 1) | ((src[i] & 1) << 1);
+        secondary[i % _DISK2_NIB_SECONDARY_LEN] |= pair << ((i / _DISK2_NIB_SECONDARY_LEN) * 2);
+    }
+    // Each nibble is the xor of two neighbouring 6-bit values, secondary buffer first
+    uint8_t prev = 0;
+    for (int i = 0; i < _DISK2_NIB_SECONDARY_LEN; i++) {
+        *dst++ = _disk2_nib_translate[(secondary[i] ^ prev) & 0x3F];
+        prev = secondary[i];
+    }
+    for (int i = 0; i < _DISK2_NIB_PRIMARY_LEN; i++) {
+        const uint8_t primary = src[i] >> 2;
+        *dst++ = _disk2_nib_translate[(primary ^ prev) & 0x3F];
+        prev = primary;
+    }
+    *dst++ = _disk2_nib_translate[prev & 0x3F];
+    return dst;
+}
+
+void disk2_nib_encode_track(uint8_t* nib_track, const uint8_t* dsk_track, uint8_t track, uint8_t volume,
+                            disk2_nib_order_t order) {
+    CHIPS_ASSERT(nib_track && dsk_track && (track < DISK2_NIB_TRACKS_PER_DISK));
+    CHIPS_ASSERT((order == DISK2_NIB_ORDER_DOS) || (order == DISK2_NIB_ORDER_PRODOS));
+    for (uint8_t sector = 0; sector < DISK2_NIB_SECTORS_PER_TRACK; sector++) {
+        const uint8_t soft_sector = _disk2_nib_soft_interleave[order][sector];
+        const uint8_t phys_sector = _disk2_nib_phys_interleave[order][sector];
+        uint8_t* dst = nib_track + phys_sector * DISK2_NIB_BYTES_PER_NIB_SECTOR;
+
+        // Address field
+        memset(dst, _DISK2_NIB_GAP_BYTE, _DISK2_NIB_GAP1_LEN);
+        dst += _DISK2_NIB_GAP1_LEN;
+        memcpy(dst, _disk2_nib_addr_prolog, 3);
+        dst = _disk2_nib_odd_even(dst + 3, volume);
+        dst = _disk2_nib_odd_even(dst, track);
+        dst = _disk2_nib_odd_even(dst, sector);
+        dst = _disk2_nib_odd_even(dst, volume ^ track ^ sector);
+        memcpy(dst, _disk2_nib_epilog, 3);
+        dst += 3;
+
+        // Data field
+        memset(dst, _DISK2_NIB_GAP_BYTE, _DISK2_NIB_GAP2_LEN);
+        dst += _DISK2_NIB_GAP2_LEN;
+        memcpy(dst, _disk2_nib_data_prolog, 3);
+        dst = _disk2_nib_encode_data(dst + 3, dsk_track + soft_sector * DISK2_NIB_BYTES_PER_SECTOR);
+        memcpy(dst, _disk2_nib_epilog, 3);
+    }
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mockingboard sound card: two 6522 VIAs, each driving an AY-3-8910 PSG.
+//
+// The card decodes A7 and A0..A3 of its $Cnxx slot page, $Cn00 is the first
+// VIA and $Cn80 the second. Port A of a VIA is the data bus of its PSG, port
+// B drives the bus control lines. Both VIA interrupts are wired to the CPU IRQ.
+// The two PSGs, left and right on the real card, are mixed to mono.
+//
+// The PSGs aren't ticked, they are rendered in blocks like the Oric PSG: the
+// system renders its audio up to the current tick before every write to the
+// card, so register changes land on the tick they were made.
+
+#define MOCKINGBOARD_NUM_PSGS  (2)
+#define MOCKINGBOARD_TICK_STEP (4)  // System ticks per mockingboard_tick() call
+
+// Port B bus control lines
+#define MOCKINGBOARD_PB_BC1   (1 << 0)
+#define MOCKINGBOARD_PB_BDIR  (1 << 1)
+#define MOCKINGBOARD_PB_RESET (1 << 2)  // Active low
+
+// Mockingboard setup
+typedef struct {
+    int tick_hz;   // System clock, also the PSG clock
+    int sound_hz;  // Output sample rate
+    float volume;  // Output volume, from 0.0 to 1.0
+} mockingboard_desc_t;
+
+// Mockingboard state
+typedef struct {
+    bool valid;
+    mos6522via_t via[MOCKINGBOARD_NUM_PSGS];
+    ay38910psg_t psg[MOCKINGBOARD_NUM_PSGS];
+} mockingboard_t;
+
+// Mockingboard interface
+
+// Initialize a new Mockingboard
+void mockingboard_init(mockingboard_t* sys, const mockingboard_desc_t* desc);
+
+// Discard the Mockingboard
+void mockingboard_discard(mockingboard_t* sys);
+
+// Reset the Mockingboard
+void mockingboard_reset(mockingboard_t* sys);
+
+// Tick the VIAs by MOCKINGBOARD_TICK_STEP system ticks, return the IRQ line state
+bool mockingboard_tick(mockingboard_t* sys);
+
+// Read from the slot page, addr is the low byte of the address
+uint8_t mockingboard_read_byte(mockingboard_t* sys, uint8_t addr);
+
+// Write to the slot page, addr is the low byte of the address
+void mockingboard_write_byte(mockingboard_t* sys, uint8_t addr, uint8_t byte);
+
+// Render both PSGs mixed up to end_tick, same protocol as ay38910psg_render()
+int mockingboard_render(mockingboard_t* sys, uint32_t end_tick, resampler_level_t* out, int max_samples);
+
+// Follow a drifting audio clock, see resampler_set_rate_adjust()
+void mockingboard_set_rate_adjust(mockingboard_t* sys, int32_t ppm);
+
+// Prepare a new Mockingboard snapshot for saving
+void mockingboard_snapshot_onsave(mockingboard_t* snapshot);
+
+// Fix up the Mockingboard snapshot after loading
+void mockingboard_snapshot_onload(mockingboard_t* snapshot, mockingboard_t* sys);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+void mockingboard_init(mockingboard_t* sys, const mockingboard_desc_t* desc) {
+    CHIPS_ASSERT(sys && !sys->valid && desc);
+    memset(sys, 0, sizeof(mockingboard_t));
+    sys->valid = true;
+    for (int i = 0; i < MOCKINGBOARD_NUM_PSGS; i++) {
+        mos6522via_init(&sys->via[i]);
+        // Three channels at full volume fill the output range
+        ay38910psg_init(&sys->psg[i], &(ay38910psg_desc_t){
+                                          .type = AY38910PSG_TYPE_8910,
+                                          .magnitude = desc->volume / 3.0f,
+                                          .tick_hz = desc->tick_hz,
+                                          .sound_hz = desc->sound_hz,
+                                      });
+    }
+}
+
+void mockingboard_discard(mockingboard_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->valid = false;
+}
+
+void mockingboard_reset(mockingboard_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    for (int i = 0; i < MOCKINGBOARD_NUM_PSGS; i++) {
+        mos6522via_reset(&sys->via[i]);
+        ay38910psg_reset(&sys->psg[i]);
+    }
+}
+
+bool mockingboard_tick(mockingboard_t* sys) {
+    bool irq = mos6522via_tick(&sys->via[0], MOCKINGBOARD_TICK_STEP);
+    irq |= mos6522via_tick(&sys->via[1], MOCKINGBOARD_TICK_STEP);
+    return irq;
+}
+
+// Run a PSG bus cycle with the control lines and data from the VIA ports
+static void _mockingboard_update_psg(mos6522via_t* via, ay38910psg_t* psg) {
+    const uint8_t pb = mos6522via_get_pb(via);
+    if (!(pb & MOCKINGBOARD_PB_RESET)) {
+        ay38910psg_reset(psg);
+        return;
+    }
+    switch (pb & (MOCKINGBOARD_PB_BDIR | MOCKINGBOARD_PB_BC1)) {
+        case MOCKINGBOARD_PB_BC1:
+            mos6522via_set_pa(via, ay38910psg_read(psg));
+            break;
+        case MOCKINGBOARD_PB_BDIR:
+            ay38910psg_write(psg, mos6522via_get_pa(via));
+            break;
+        case MOCKINGBOARD_PB_BDIR | MOCKINGBOARD_PB_BC1:
+            ay38910psg_latch_address(psg, mos6522via_get_pa(via));
+            break;
+        default:
+            // Inactive
+            break;
+    }
+}
+
+uint8_t mockingboard_read_byte(mockingboard_t* sys, uint8_t addr) {
+    return mos6522via_read(&sys->via[addr >> 7], addr & 0x0F);
+}
+
+void mockingboard_write_byte(mockingboard_t* sys, uint8_t addr, uint8_t byte) {
+    const int i = addr >> 7;
+    mos6522via_write(&sys->via[i], addr & 0x0F, byte);
+    switch (addr & 0x0F) {
+        case MOS6522VIA_REG_RB:
+        case MOS6522VIA_REG_RA:
+        case MOS6522VIA_REG_DDRB:
+        case MOS6522VIA_REG_DDRA:
+        case MOS6522VIA_REG_RA_NOH:
+            _mockingboard_update_psg(&sys->via[i], &sys->psg[i]);
+            break;
+        default:
+            break;
+    }
+}
+
+int mockingboard_render(mockingboard_t* sys, uint32_t end_tick, resampler_level_t* out, int max_samples) {
+    CHIPS_ASSERT(sys && sys->valid && out && (max_samples > 0) && (max_samples <= 32));
+    resampler_level_t second[32];
+    // Both PSGs run on the same clock and output rate, they stay in step
+    const int num_samples = ay38910psg_render(&sys->psg[0], end_tick, out, max_samples);
+    const int n = ay38910psg_render(&sys->psg[1], end_tick, second, max_samples);
+    CHIPS_ASSERT(n == num_samples);
+    (void)n;
+    for (int i = 0; i < num_samples; i++) {
+        out[i] = resampler_mul(out[i] + second[i], RESAMPLER_LEVEL(0.5f));
+    }
+    return num_samples;
+}
+
+void mockingboard_set_rate_adjust(mockingboard_t* sys, int32_t ppm) {
+    CHIPS_ASSERT(sys && sys->valid);
+    for (int i = 0; i < MOCKINGBOARD_NUM_PSGS; i++) {
+        resampler_set_rate_adjust(&sys->psg[i].resampler, ppm);
+    }
+}
+
+void mockingboard_snapshot_onsave(mockingboard_t* snapshot) {
+    CHIPS_ASSERT(snapshot);
+    for (int i = 0; i < MOCKINGBOARD_NUM_PSGS; i++) {
+        ay38910psg_snapshot_onsave(&snapshot->psg[i]);
+    }
+}
+
+void mockingboard_snapshot_onload(mockingboard_t* snapshot, mockingboard_t* sys) {
+    CHIPS_ASSERT(snapshot && sys);
+    for (int i = 0; i < MOCKINGBOARD_NUM_PSGS; i++) {
+        ay38910psg_snapshot_onload(&snapshot->psg[i], &sys->psg[i]);
+    }
+}
+
+#endif /* CHIPS_IMPL */
@@ -22,17 +22,22 @@
 
     - chips/chips_common.h
     - chips/wdc65C02cpu.h
+    - chips/resampler.h
     - chips/beeper.h
+    - chips/mos6522via.h
+    - chips/ay38910psg.h
     - chips/kbd.h
     - chips/mem.h
     - chips/clk.h
     - devices/apple2_lc.h
+    - devices/disk2_nib.h
     - devices/disk2_fdd.h
     - devices/disk2_fdc.h
     - devices/apple2_fdc_rom.h
     - devices/prodos_hdd.h
     - devices/prodos_hdc.h
     - devices/prodos_hdc_rom.h
+    - devices/mockingboard.h
 
     ## The Apple ][
 
@@ -71,22 +76,30 @@ extern "C" {
 #endif
 
 // Bump snapshot version when apple2_t memory layout changes
-#define APPLE2_SNAPSHOT_VERSION (1)
+#define APPLE2_SNAPSHOT_VERSION (11)
 
 #define APPLE2_FREQUENCY             (1021800)
 #define APPLE2_MAX_AUDIO_SAMPLES     (2048)  // Max number of audio samples in internal sample buffer
-#define APPLE2_DEFAULT_AUDIO_SAMPLES (2048)  // Default number of samples in internal sample buffer
+#define APPLE2_DEFAULT_AUDIO_SAMPLES (256)   // Default number of samples in internal sample buffer
 
 #define APPLE2_SCREEN_WIDTH     560  // (280 * 2)
 #define APPLE2_SCREEN_HEIGHT    192  // (192)
 #define APPLE2_FRAMEBUFFER_SIZE ((APPLE2_SCREEN_WIDTH / 2) * APPLE2_SCREEN_HEIGHT)
 
+#ifndef APPLE2_FRAMEBUFFER
+// Set to 0 to drop fb and render scanlines on demand with apple2_render_line()
+#define APPLE2_FRAMEBUFFER (1)
+#endif  // APPLE2_FRAMEBUFFER
+
 // Config parameters for apple2_init()
 typedef struct {
-    bool fdc_enabled;         // Set to true to enable floppy disk controller emulation
-    bool hdc_enabled;         // Set to true to enable hard disk controller emulation
-    bool hdc_internal_flash;  // Set to true to use internal flash
-    chips_debug_t debug;      // Optional debugging hook
+    bool fdc_enabled;           // Set to true to enable floppy disk controller emulation
+    bool hdc_enabled;           // Set to true to enable hard disk controller emulation
+    bool hdc_internal_flash;    // Set to true to use internal flash
+    bool mockingboard_enabled;  // Set to true to add a Mockingboard sound card in slot 4
+    bool composite;             // Set to true to render the NTSC dot stream (decode with util/ntsc.h)
+    bool shared_lines;          // Set to true to let identical scanlines share fb rows, read rows through fb_line[]
+    chips_debug_t debug;        // Optional debugging hook
     chips_audio_desc_t audio;
     struct {
         chips_range_t rom;
@@ -133,12 +146,20 @@ typedef struct {
     bool hires_page1_dirty;
     bool hires_page2_dirty;
 
+    bool composite;  // fb holds the monochrome dot stream instead of artifact colors
+#if APPLE2_FRAMEBUFFER
     uint8_t fb[APPLE2_FRAMEBUFFER_SIZE];
+    uint32_t fb_dirty_rows[CHIPS_FB_DIRTY_WORDS(APPLE2_SCREEN_HEIGHT)];  // fb rows rewritten, cleared by the frontend
+    uint8_t fb_line[APPLE2_SCREEN_HEIGHT];  // fb row holding each scanline, only differs from y with shared_lines
+    bool shared_lines;
+#endif
 
     disk2_fdc_t fdc;  // Disk II floppy disk controller
 
     prodos_hdc_t hdc;  // ProDOS hard disk controller
 
+    mockingboard_t mb;  // Mockingboard sound card
+
     uint8_t last_key_code;
 
     uint32_t system_ticks;
@@ -157,6 +178,10 @@ void apple2_tick(apple2_t *sys);
 
 // tick Apple2 instance for a given number of microseconds, return number of executed ticks
 uint32_t apple2_exec(apple2_t *sys, uint32_t micro_seconds);
+// synthesize the audio samples for the speaker toggles so far, call after ticking the Apple2 directly
+void apple2_flush_audio(apple2_t *sys);
+// speed the audio output up or slow it down by ppm parts per million, call after apple2_flush_audio()
+void apple2_set_audio_rate_adjust(apple2_t *sys, int32_t ppm);
 // send a key-down event to the Apple2
 void apple2_key_down(apple2_t *sys, int key_code);
 // send a key-up event to the Apple2
@@ -166,7 +191,16 @@ uint32_t apple2_save_snapshot(apple2_t *sys, apple2_t *dst);
 // load a snapshot, returns false if snapshot version doesn't match
 bool apple2_load_snapshot(apple2_t *sys, uint32_t version, apple2_t *src);
 
+#if APPLE2_FRAMEBUFFER
 void apple2_screen_update(apple2_t *sys);
+#endif
+// render scanline y of the current video mode from RAM into out (APPLE2_SCREEN_WIDTH / 2 bytes)
+void apple2_render_line(apple2_t *sys, int y, uint8_t *out);
+
+// switch between artifact color and composite dot stream rendering
+void apple2_set_composite(apple2_t *sys, bool composite);
+// decode the displayed text page from RAM without rendering, returns false in full screen graphics modes
+bool apple2_text_screen(apple2_t *sys, chips_text_screen_t *screen);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -195,6 +229,29 @@ static uint8_t __not_in_flash() _apple2_artifact_color_lut[1<<7] = {
 };
 // clang-format on
 
+// Sector images, images/apple2_images.h defines APPLE2_DSK_IMAGES when it lists apple2_dsk_images[]
+#ifndef APPLE2_DSK_IMAGES
+#define APPLE2_DSK_IMAGES
+#define APPLE2_NUM_DSK_IMAGES (0)
+static const disk2_nib_dsk_image_t* const apple2_dsk_images = NULL;
+#endif
+#ifndef APPLE2_NUM_DSK_IMAGES
+#define APPLE2_NUM_DSK_IMAGES ((int)CHIPS_ARRAY_SIZE(apple2_dsk_images))
+#endif
+
+// Insert floppy image index, counting the NIB images first and then the sector images
+static void _apple2_insert_floppy(apple2_t *sys, int index) {
+    int num_nib_images = CHIPS_ARRAY_SIZE(apple2_nib_images);
+    if (index < num_nib_images) {
+        disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[index]);
+    } else {
+        index -= num_nib_images;
+        if (index < APPLE2_NUM_DSK_IMAGES) {
+            disk2_fdd_insert_dsk(&sys->fdc.fdd[0], apple2_dsk_images[index].image, apple2_dsk_images[index].order);
+        }
+    }
+}
+
 extern bool msc_inquiry_complete;
 
 void apple2_init(apple2_t *sys, const apple2_desc_t *desc) {
@@ -238,12 +295,27 @@ void apple2_init(apple2_t *sys, const apple2_desc_t *desc) {
 
     sys->last_key_code = 0x0D | 0x80;
 
+    sys->composite = desc->composite;
+#if APPLE2_FRAMEBUFFER
+    sys->shared_lines = desc->shared_lines;
+    for (int y = 0; y < APPLE2_SCREEN_HEIGHT; y++) {
+        sys->fb_line[y] = y;
+    }
+#endif
+
     // Optionally setup floppy disk controller
     if (desc->fdc_enabled) {
         disk2_fdc_init(&sys->fdc);
-        if (CHIPS_ARRAY_SIZE(apple2_nib_images) > 0) {
-            disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[0]);
-        }
+        _apple2_insert_floppy(sys, 0);
+    }
+
+    // Optionally setup Mockingboard
+    if (desc->mockingboard_enabled) {
+        mockingboard_init(&sys->mb, &(mockingboard_desc_t){
+                                        .tick_hz = APPLE2_FREQUENCY,
+                                        .sound_hz = CHIPS_DEFAULT(desc->audio.sample_rate, 22050),
+                                        .volume = CHIPS_DEFAULT(desc->audio.volume, 1.0f),
+                                    });
     }
 
     // Optionally setup hard disk controller
@@ -274,6 +346,9 @@ void apple2_discard(apple2_t *sys) {
     if (sys->hdc.valid) {
         prodos_hdc_discard(&sys->hdc);
     }
+    if (sys->mb.valid) {
+        mockingboard_discard(&sys->mb);
+    }
     sys->valid = false;
 }
 
@@ -287,6 +362,9 @@ void apple2_reset(apple2_t *sys) {
     if (sys->hdc.valid) {
         prodos_hdc_reset(&sys->hdc);
     }
+    if (sys->mb.valid) {
+        mockingboard_reset(&sys->mb);
+    }
     wdc65C02cpu_reset();
 }
 
@@ -305,7 +383,7 @@ static void _apple2_mem_c000_c0ff_rw(apple2_t *sys, uint16_t addr, bool rw) {
             break;
 
         case 0x30:
-            beeper_toggle(&sys->beeper);
+            beeper_toggle_at(&sys->beeper, sys->system_ticks);
             break;
 
         case 0x50:
@@ -382,10 +460,22 @@ static void _apple2_mem_c000_c0ff_rw(apple2_t *sys, uint16_t addr, bool rw) {
     }
 }
 
+static void _apple2_render_audio(apple2_t *sys, uint32_t end_tick);
+
 static void _apple2_mem_rw(apple2_t *sys, uint16_t addr, bool rw) {
     if ((addr >= 0xC000) && (addr <= 0xC0FF)) {
         // Apple II I/O Page
         _apple2_mem_c000_c0ff_rw(sys, addr, rw);
+    } else if ((addr >= 0xC400) && (addr <= 0xC4FF) && sys->mb.valid) {
+        // Mockingboard
+        if (rw) {
+            // Memory read
+            wdc65C02cpu_set_data(mockingboard_read_byte(&sys->mb, addr & 0xFF));
+        } else {
+            // Memory write, samples up to this tick still use the old PSG registers
+            _apple2_render_audio(sys, sys->system_ticks + 1);
+            mockingboard_write_byte(&sys->mb, addr & 0xFF, wdc65C02cpu_get_data());
+        }
     } else if ((addr >= 0xC600) && (addr <= 0xC6FF)) {
         // Disk II boot rom
         if (rw) {
@@ -427,27 +517,16 @@ void apple2_tick(apple2_t *sys) {
 
     _apple2_mem_rw(sys, addr, rw);
 
-    // Update beeper
-    if (beeper_tick(&sys->beeper)) {
-        // New audio sample ready
-        // sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)((sys->beeper.sample * 0.5f + 0.5f) *
-        // 255.0f);
-        sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)(sys->beeper.sample * 255.0f);
-        if (sys->audio.sample_pos == sys->audio.num_samples) {
-            if (sys->audio.callback.func) {
-                // New sample packet is ready
-                sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
-                                         sys->audio.callback.user_data);
-            }
-            sys->audio.sample_pos = 0;
-        }
-    }
-
     // Tick FDC
     if (sys->fdc.valid && (sys->system_ticks & 127) == 0) {
         disk2_fdc_tick(&sys->fdc);
     }
 
+    // Tick Mockingboard VIAs, the PSGs are rendered in blocks up to each write and in apple2_flush_audio()
+    if (sys->mb.valid && (sys->system_ticks & (MOCKINGBOARD_TICK_STEP - 1)) == 0) {
+        wdc65C02cpu_set_irq(mockingboard_tick(&sys->mb));
+    }
+
     if (sys->flash_timer_ticks > 0) {
         sys->flash_timer_ticks--;
         if (sys->flash_timer_ticks == 0) {
@@ -464,6 +543,51 @@ void apple2_tick(apple2_t *sys) {
     sys->system_ticks++;
 }
 
+static void _apple2_render_audio(apple2_t *sys, uint32_t end_tick) {
+    resampler_level_t samples[32];
+    resampler_level_t mb_samples[32];
+    int num_samples;
+    do {
+        num_samples = beeper_flush(&sys->beeper, end_tick, samples, 32);
+        if (sys->mb.valid) {
+            // The PSGs share the speaker's output clock, rendered up to the same tick they give as many samples
+            const int n = mockingboard_render(&sys->mb, end_tick, mb_samples, 32);
+            CHIPS_ASSERT(n == num_samples);
+            (void)n;
+        }
+        for (int i = 0; i < num_samples; i++) {
+            // Band-limited steps ring past the speaker levels, keep them in range
+            resampler_level_t s =
+                resampler_mul(samples[i], RESAMPLER_LEVEL(2.0f / 3.0f)) + RESAMPLER_LEVEL(1.0f / 6.0f);
+            if (sys->mb.valid) {
+                s = resampler_mul(s + mb_samples[i], RESAMPLER_LEVEL(0.5f));
+            }
+            sys->audio.sample_buffer[sys->audio.sample_pos++] = resampler_to_u8(s);
+            if (sys->audio.sample_pos == sys->audio.num_samples) {
+                if (sys->audio.callback.func) {
+                    // New sample packet is ready
+                    sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
+                                             sys->audio.callback.user_data);
+                }
+                sys->audio.sample_pos = 0;
+            }
+        }
+    } while (num_samples == 32);
+}
+
+void apple2_flush_audio(apple2_t *sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    _apple2_render_audio(sys, sys->system_ticks);
+}
+
+void apple2_set_audio_rate_adjust(apple2_t *sys, int32_t ppm) {
+    CHIPS_ASSERT(sys && sys->valid);
+    resampler_set_rate_adjust(&sys->beeper.resampler, ppm);
+    if (sys->mb.valid) {
+        mockingboard_set_rate_adjust(&sys->mb, ppm);
+    }
+}
+
 uint32_t apple2_exec(apple2_t *sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
     uint32_t num_ticks = clk_us_to_ticks(APPLE2_FREQUENCY, micro_seconds);
@@ -480,8 +604,11 @@ uint32_t apple2_exec(apple2_t *sys, uint32_t micro_seconds) {
             sys->debug.callback.func(sys->debug.callback.user_data, 0);
         }
     }
+    apple2_flush_audio(sys);
     // kbd_update(&sys->kbd, micro_seconds);
+#if APPLE2_FRAMEBUFFER
     apple2_screen_update(sys);
+#endif
 
     // printf("executed %d ticks\n", num_ticks);
     return num_ticks;
@@ -515,10 +642,7 @@ void apple2_key_down(apple2_t *sys, int key_code) {
         case 0x142:  // F9
         {
             if (sys->fdc.valid) {
-                uint8_t index = key_code - 0x13A;
-                if (CHIPS_ARRAY_SIZE(apple2_nib_images) > index) {
-                    disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[index]);
-                }
+                _apple2_insert_floppy(sys, key_code - 0x13A);
             }
             break;
         }
@@ -550,6 +674,7 @@ uint32_t apple2_save_snapshot(apple2_t *sys, apple2_t *dst) {
     chips_audio_callback_snapshot_onsave(&dst->audio.callback);
     // m6502_snapshot_onsave(&dst->cpu);
     disk2_fdc_snapshot_onsave(&dst->fdc);
+    mockingboard_snapshot_onsave(&dst->mb);
     mem_snapshot_onsave(&dst->mem, sys);
     return APPLE2_SNAPSHOT_VERSION;
 }
@@ -565,6 +690,7 @@ bool apple2_load_snapshot(apple2_t *sys, uint32_t version, apple2_t *src) {
     chips_audio_callback_snapshot_onload(&im.audio.callback, &sys->audio.callback);
     // m6502_snapshot_onload(&im.cpu, &sys->cpu);
     disk2_fdc_snapshot_onload(&im.fdc, &sys->fdc);
+    mockingboard_snapshot_onload(&im.mb, &sys->mb);
     mem_snapshot_onload(&im.mem, sys);
     *sys = im;
     return true;
@@ -630,6 +756,9 @@ static void _apple2_render_line_color(uint8_t *out, uint16_t *in, int start_col,
     }
 }
 
+// Two composite dots from the low bits of a lores color pattern
+static inline uint8_t _apple2_dot_pair(uint8_t bits) { return ((bits & 1) ? 0xF0 : 0) | ((bits & 2) ? 0x0F : 0); }
+
 static uint8_t _apple2_get_text_character(apple2_t *sys, uint8_t code, uint16_t row) {
     uint8_t invert_mask = 0;
 
@@ -649,36 +778,108 @@ static uint8_t _apple2_get_text_character(apple2_t *sys, uint8_t code, uint16_t
     return _apple2_reverse_7_bits(bits);
 }
 
-static uint8_t *_apple2_get_fb_addr(apple2_t *sys, uint16_t row) { return &sys->fb[row * (APPLE2_SCREEN_WIDTH / 2)]; }
+static void _apple2_render_lores_line(apple2_t *sys, uint16_t row, uint8_t *p) {
+    uint16_t start_address = sys->page2 ? 0x0800 : 0x0400;
+    uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
+    uint8_t *vram_row = &sys->ram[address];
+
+#define NIBBLE(byte) (((byte) >> (row & 4)) & 0x0F)
+    for (int col = 0; col < 40; col++) {
+        uint8_t c = NIBBLE(vram_row[col]);
+        if (sys->composite) {
+            // The color pattern repeats every 4 dots, a byte holds dots 0-1 or 2-3 of it
+            uint8_t dots[2] = {_apple2_dot_pair(c), _apple2_dot_pair(c >> 2)};
+            for (int b = 0; b < 7; b++) {
+                *p++ = dots[(col * 7 + b) & 1];
+            }
+        } else {
+            for (int b = 0; b < 7; b++) {
+                *p = c << 4;
+                *p++ |= c;
+            }
+        }
+    }
+#undef NIBBLE
+}
+
+static void _apple2_render_text_line(apple2_t *sys, uint16_t row, uint8_t *out) {
+    uint16_t start_address = sys->page2 ? 0x0800 : 0x0400;
+    uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
+    uint8_t *vram_row = &sys->ram[address];
+
+    uint16_t words[40];
+
+    for (int col = 0; col < 40; col++) {
+        words[col] = _apple2_double_7_bits(_apple2_get_text_character(sys, vram_row[col], row & 7));
+    }
+
+    _apple2_render_line_monochrome(out, words, 0, 40);
+}
+
+static void _apple2_render_hgr_line(apple2_t *sys, uint16_t row, uint8_t *out) {
+    uint16_t start_address = sys->page2 ? 0x4000 : 0x2000;
+    uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
+    uint8_t *vram_row = &sys->ram[address];
+
+    uint16_t words[40];
+
+    uint16_t last_output_bit = 0;
+
+    for (int col = 0; col < 40; col++) {
+        uint16_t w = _apple2_double_7_bits(vram_row[col] & 0x7F);
+        if (vram_row[col] & 0x80) {
+            w = (w << 1 | last_output_bit) & 0x3FFF;
+        };
+        words[col] = w;
+        last_output_bit = w >> 13;
+    }
+
+    if (sys->composite) {
+        _apple2_render_line_monochrome(out, words, 0, 40);
+    } else {
+        _apple2_render_line_color(out, words, 0, 40);
+    }
+}
+
+// Reads only RAM and the mode switches, so it can run at scan-out time without a framebuffer
+void apple2_render_line(apple2_t *sys, int y, uint8_t *out) {
+    CHIPS_ASSERT(sys && sys->valid && out && (y >= 0) && (y < APPLE2_SCREEN_HEIGHT));
+    if (sys->text || (sys->mixed && (y >= 160))) {
+        _apple2_render_text_line(sys, y, out);
+    } else if (sys->hires) {
+        _apple2_render_hgr_line(sys, y, out);
+    } else {
+        _apple2_render_lores_line(sys, y, out);
+    }
+}
+
+#if APPLE2_FRAMEBUFFER
+// Rows are only fetched to be rendered, so flag them as rewritten and showing their own row here
+static uint8_t *_apple2_get_fb_addr(apple2_t *sys, uint16_t row) {
+    chips_fb_dirty_set(sys->fb_dirty_rows, row);
+    sys->fb_line[row] = row;
+    return &sys->fb[row * (APPLE2_SCREEN_WIDTH / 2)];
+}
 
 static void _apple2_lores_update(apple2_t *sys, uint16_t begin_row, uint16_t end_row) {
     if ((!sys->page2 && !sys->text_page1_dirty) || (sys->page2 && !sys->text_page2_dirty)) {
         return;
     }
 
-    uint16_t start_address = sys->page2 ? 0x0800 : 0x0400;
-
     uint16_t start_row = (begin_row / 8) * 8;
     uint16_t stop_row = ((end_row / 8) + 1) * 8;
 
     for (int row = start_row; row < stop_row; row += 4) {
-        uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
-        uint8_t *vram_row = &sys->ram[address];
-
-#define NIBBLE(byte) (((byte) >> (row & 4)) & 0x0F)
-        uint8_t *p = _apple2_get_fb_addr(sys, row);
-
-        for (int col = 0; col < 40; col++) {
-            uint8_t c = NIBBLE(vram_row[col]);
-            for (int b = 0; b < 7; b++) {
-                *p = c << 4;
-                *p++ |= c;
-            }
-        }
-#undef NIBBLE
+        _apple2_render_lores_line(sys, row, _apple2_get_fb_addr(sys, row));
 
         for (int y = 1; y < 4; y++) {
-            memcpy(_apple2_get_fb_addr(sys, row + y), _apple2_get_fb_addr(sys, row), 40 * 7);
+            if (sys->shared_lines) {
+                // All 4 lines of a lores block are equal, point them to the rendered one
+                sys->fb_line[row + y] = row;
+                chips_fb_dirty_set(sys->fb_dirty_rows, row + y);
+            } else {
+                memcpy(_apple2_get_fb_addr(sys, row + y), _apple2_get_fb_addr(sys, row), 40 * 7);
+            }
         }
     }
 
@@ -694,22 +895,11 @@ static void _apple2_text_update(apple2_t *sys, uint16_t begin_row, uint16_t end_
         return;
     }
 
-    uint16_t start_address = sys->page2 ? 0x0800 : 0x0400;
-
     uint16_t start_row = (begin_row / 8) * 8;
     uint16_t stop_row = ((end_row / 8) + 1) * 8;
 
     for (int row = start_row; row < stop_row; row++) {
-        uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
-        uint8_t *vram_row = &sys->ram[address];
-
-        uint16_t words[40];
-
-        for (int col = 0; col < 40; col++) {
-            words[col] = _apple2_double_7_bits(_apple2_get_text_character(sys, vram_row[col], row & 7));
-        }
-
-        _apple2_render_line_monochrome(_apple2_get_fb_addr(sys, row), words, 0, 40);
+        _apple2_render_text_line(sys, row, _apple2_get_fb_addr(sys, row));
     }
 
     if (!sys->page2) {
@@ -724,26 +914,8 @@ static void _apple2_hgr_update(apple2_t *sys, uint16_t begin_row, uint16_t end_r
         return;
     }
 
-    uint16_t start_address = sys->page2 ? 0x4000 : 0x2000;
-
     for (int row = begin_row; row <= end_row; row++) {
-        uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
-        uint8_t *vram_row = &sys->ram[address];
-
-        uint16_t words[40];
-
-        uint16_t last_output_bit = 0;
-
-        for (int col = 0; col < 40; col++) {
-            uint16_t w = _apple2_double_7_bits(vram_row[col] & 0x7F);
-            if (vram_row[col] & 0x80) {
-                w = (w << 1 | last_output_bit) & 0x3FFF;
-            };
-            words[col] = w;
-            last_output_bit = w >> 13;
-        }
-
-        _apple2_render_line_color(_apple2_get_fb_addr(sys, row), words, 0, 40);
+        _apple2_render_hgr_line(sys, row, _apple2_get_fb_addr(sys, row));
     }
 
     if (!sys->page2) {
@@ -770,5 +942,49 @@ void apple2_screen_update(apple2_t *sys) {
         _apple2_text_update(sys, text_start_row, 191);
     }
 }
+#endif  // APPLE2_FRAMEBUFFER
+
+void apple2_set_composite(apple2_t *sys, bool composite) {
+    CHIPS_ASSERT(sys && sys->valid);
+    if (sys->composite != composite) {
+        sys->composite = composite;
+        sys->text_page1_dirty = sys->text_page2_dirty = true;
+        sys->hires_page1_dirty = sys->hires_page2_dirty = true;
+    }
+}
+
+// Screen code to ASCII, the character ROM only has 64 glyphs shown inverse, flashing or normal
+static char _apple2_text_ascii(uint8_t code, uint8_t *attrs) {
+    *attrs = (code < 0x40) ? CHIPS_TEXT_INVERSE : (code < 0x80) ? CHIPS_TEXT_FLASH : 0;
+    code &= 0x3F;
+    return (char)((code < 0x20) ? (code + 0x40) : code);
+}
+
+bool apple2_text_screen(apple2_t *sys, chips_text_screen_t *screen) {
+    CHIPS_ASSERT(sys && sys->valid && screen);
+    if (!sys->text && !sys->mixed) {
+        return false;
+    }
+
+    screen->columns = 40;
+    screen->rows = 24;
+    screen->first_row = sys->text ? 0 : 20;
+
+    uint16_t start_address = sys->page2 ? 0x0800 : 0x0400;
+
+    for (int row = 0; row < 24; row++) {
+        uint8_t *vram_row = &sys->ram[start_address + ((row & 0x07) << 7) + ((row & 0x18) * 5)];
+        for (int col = 0; col < 40; col++) {
+            if (row < screen->first_row) {
+                screen->chars[row][col] = ' ';
+                screen->attrs[row][col] = 0;
+            } else {
+                screen->chars[row][col] = _apple2_text_ascii(vram_row[col], &screen->attrs[row][col]);
+            }
+            screen->colors[row][col] = 0x0F;
+        }
+    }
+    return true;
+}
 
 #endif  // CHIPS_IMPL
@@ -22,17 +22,22 @@
 
     - chips/chips_common.h
     - chips/wdc65C02cpu.h
+    - chips/resampler.h
     - chips/beeper.h
+    - chips/mos6522via.h
+    - chips/ay38910psg.h
     - chips/kbd.h
     - chips/mem.h
     - chips/clk.h
     - devices/apple2_lc.h
+    - devices/disk2_nib.h
     - devices/disk2_fdd.h
     - devices/disk2_fdc.h
     - devices/apple2_fdc_rom.h
     - devices/prodos_hdd.h
     - devices/prodos_hdc.h
     - devices/prodos_hdc_rom.h
+    - devices/mockingboard.h
 
     ## The Apple //e
 
@@ -71,22 +76,30 @@ extern "C" {
 #endif
 
 // Bump snapshot version when apple2e_t memory layout changes
-#define APPLE2E_SNAPSHOT_VERSION (1)
+#define APPLE2E_SNAPSHOT_VERSION (11)
 
 #define APPLE2E_FREQUENCY             (1021800)
 #define APPLE2E_MAX_AUDIO_SAMPLES     (2048)  // Max number of audio samples in internal sample buffer
-#define APPLE2E_DEFAULT_AUDIO_SAMPLES (2048)  // Default number of samples in internal sample buffer
+#define APPLE2E_DEFAULT_AUDIO_SAMPLES (256)   // Default number of samples in internal sample buffer
 
 #define APPLE2E_SCREEN_WIDTH     560  // (280 * 2)
 #define APPLE2E_SCREEN_HEIGHT    192  // (192)
 #define APPLE2E_FRAMEBUFFER_SIZE ((APPLE2E_SCREEN_WIDTH / 2) * APPLE2E_SCREEN_HEIGHT)
 
+#ifndef APPLE2E_FRAMEBUFFER
+// Set to 0 to drop fb and render scanlines on demand with apple2e_render_line()
+#define APPLE2E_FRAMEBUFFER (1)
+#endif  // APPLE2E_FRAMEBUFFER
+
 // Config parameters for apple2e_init()
 typedef struct {
-    bool fdc_enabled;         // Set to true to enable floppy disk controller emulation
-    bool hdc_enabled;         // Set to true to enable hard disk controller emulation
-    bool hdc_internal_flash;  // Set to true to use internal flash
-    chips_debug_t debug;      // Optional debugging hook
+    bool fdc_enabled;           // Set to true to enable floppy disk controller emulation
+    bool hdc_enabled;           // Set to true to enable hard disk controller emulation
+    bool hdc_internal_flash;    // Set to true to use internal flash
+    bool mockingboard_enabled;  // Set to true to add a Mockingboard sound card in slot 4
+    bool composite;             // Set to true to render the NTSC dot stream (decode with util/ntsc.h)
+    bool shared_lines;          // Set to true to let identical scanlines share fb rows, read rows through fb_line[]
+    chips_debug_t debug;        // Optional debugging hook
     chips_audio_desc_t audio;
     struct {
         chips_range_t rom;
@@ -148,12 +161,20 @@ typedef struct {
     bool hires_page1_dirty;
     bool hires_page2_dirty;
 
+    bool composite;  // fb holds the monochrome dot stream instead of artifact colors
+#if APPLE2E_FRAMEBUFFER
     uint8_t fb[APPLE2E_FRAMEBUFFER_SIZE];
+    uint32_t fb_dirty_rows[CHIPS_FB_DIRTY_WORDS(APPLE2E_SCREEN_HEIGHT)];  // fb rows rewritten, cleared by the frontend
+    uint8_t fb_line[APPLE2E_SCREEN_HEIGHT];  // fb row holding each scanline, only differs from y with shared_lines
+    bool shared_lines;
+#endif
 
     disk2_fdc_t fdc;  // Disk II floppy disk controller
 
     prodos_hdc_t hdc;  // ProDOS hard disk controller
 
+    mockingboard_t mb;  // Mockingboard sound card
+
     uint8_t last_key_code;
 
     bool open_apple_pressed;
@@ -176,6 +197,10 @@ void apple2e_tick(apple2e_t *sys);
 
 // tick Apple2e instance for a given number of microseconds, return number of executed ticks
 uint32_t apple2e_exec(apple2e_t *sys, uint32_t micro_seconds);
+// synthesize the audio samples for the speaker toggles so far, call after ticking the Apple2e directly
+void apple2e_flush_audio(apple2e_t *sys);
+// speed the audio output up or slow it down by ppm parts per million, call after apple2e_flush_audio()
+void apple2e_set_audio_rate_adjust(apple2e_t *sys, int32_t ppm);
 // send a key-down event to the Apple2e
 void apple2e_key_down(apple2e_t *sys, int key_code);
 // send a key-up event to the Apple2e
@@ -185,7 +210,16 @@ uint32_t apple2e_save_snapshot(apple2e_t *sys, apple2e_t *dst);
 // load a snapshot, returns false if snapshot version doesn't match
 bool apple2e_load_snapshot(apple2e_t *sys, uint32_t version, apple2e_t *src);
 
+#if APPLE2E_FRAMEBUFFER
 void apple2e_screen_update(apple2e_t *sys);
+#endif
+// render scanline y of the current video mode from RAM into out (APPLE2E_SCREEN_WIDTH / 2 bytes)
+void apple2e_render_line(apple2e_t *sys, int y, uint8_t *out);
+
+// switch between artifact color and composite dot stream rendering
+void apple2e_set_composite(apple2e_t *sys, bool composite);
+// decode the displayed 40/80 column text page from RAM without rendering, returns false in full screen graphics modes
+bool apple2e_text_screen(apple2e_t *sys, chips_text_screen_t *screen);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -214,6 +248,29 @@ static uint8_t __not_in_flash() _apple2e_artifact_color_lut[1<<7] = {
 };
 // clang-format on
 
+// Sector images, images/apple2_images.h defines APPLE2_DSK_IMAGES when it lists apple2_dsk_images[]
+#ifndef APPLE2_DSK_IMAGES
+#define APPLE2_DSK_IMAGES
+#define APPLE2_NUM_DSK_IMAGES (0)
+static const disk2_nib_dsk_image_t* const apple2_dsk_images = NULL;
+#endif
+#ifndef APPLE2_NUM_DSK_IMAGES
+#define APPLE2_NUM_DSK_IMAGES ((int)CHIPS_ARRAY_SIZE(apple2_dsk_images))
+#endif
+
+// Insert floppy image index, counting the NIB images first and then the sector images
+static void _apple2e_insert_floppy(apple2e_t *sys, int index) {
+    int num_nib_images = CHIPS_ARRAY_SIZE(apple2_nib_images);
+    if (index < num_nib_images) {
+        disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[index]);
+    } else {
+        index -= num_nib_images;
+        if (index < APPLE2_NUM_DSK_IMAGES) {
+            disk2_fdd_insert_dsk(&sys->fdc.fdd[0], apple2_dsk_images[index].image, apple2_dsk_images[index].order);
+        }
+    }
+}
+
 extern bool msc_inquiry_complete;
 
 void apple2e_init(apple2e_t *sys, const apple2e_desc_t *desc) {
@@ -258,12 +315,27 @@ void apple2e_init(apple2e_t *sys, const apple2e_desc_t *desc) {
 
     sys->last_key_code = 0x0D | 0x80;
 
+    sys->composite = desc->composite;
+#if APPLE2E_FRAMEBUFFER
+    sys->shared_lines = desc->shared_lines;
+    for (int y = 0; y < APPLE2E_SCREEN_HEIGHT; y++) {
+        sys->fb_line[y] = y;
+    }
+#endif
+
     // Optionally setup floppy disk controller
     if (desc->fdc_enabled) {
         disk2_fdc_init(&sys->fdc);
-        if (CHIPS_ARRAY_SIZE(apple2_nib_images) > 0) {
-            disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[0]);
-        }
+        _apple2e_insert_floppy(sys, 0);
+    }
+
+    // Optionally setup Mockingboard
+    if (desc->mockingboard_enabled) {
+        mockingboard_init(&sys->mb, &(mockingboard_desc_t){
+                                        .tick_hz = APPLE2E_FREQUENCY,
+                                        .sound_hz = CHIPS_DEFAULT(desc->audio.sample_rate, 22050),
+                                        .volume = CHIPS_DEFAULT(desc->audio.volume, 1.0f),
+                                    });
     }
 
     // Optionally setup hard disk controller
@@ -293,6 +365,9 @@ void apple2e_discard(apple2e_t *sys) {
     if (sys->hdc.valid) {
         prodos_hdc_discard(&sys->hdc);
     }
+    if (sys->mb.valid) {
+        mockingboard_discard(&sys->mb);
+    }
     sys->valid = false;
 }
 
@@ -305,6 +380,9 @@ void apple2e_reset(apple2e_t *sys) {
     if (sys->hdc.valid) {
         prodos_hdc_reset(&sys->hdc);
     }
+    if (sys->mb.valid) {
+        mockingboard_reset(&sys->mb);
+    }
     wdc65C02cpu_reset();
 }
 
@@ -708,7 +786,7 @@ static void _apple2e_mem_c000_c0ff_rw(apple2e_t *sys, uint16_t addr, bool rw) {
                 }
             } else if ((addr >= 0xC030) && (addr <= 0xC03F)) {
                 // Speaker
-                beeper_toggle(&sys->beeper);
+                beeper_toggle_at(&sys->beeper, sys->system_ticks);
             } else if ((addr >= 0xC080) && (addr <= 0xC08F)) {
                 // 16K Language Card
                 _apple2e_lc_control(sys, addr & 0xF, rw);
@@ -738,11 +816,23 @@ static void _apple2e_mem_c000_c0ff_rw(apple2e_t *sys, uint16_t addr, bool rw) {
     }
 }
 
+static void _apple2e_render_audio(apple2e_t *sys, uint32_t end_tick);
+
 static void _apple2e_mem_rw(apple2e_t *sys, uint16_t addr, bool rw) {
     if ((addr >= 0xC000) && (addr <= 0xCFFF)) {
         if ((addr >= 0xC000) && (addr <= 0xC0FF)) {
             // Apple //e I/O Page
             _apple2e_mem_c000_c0ff_rw(sys, addr, rw);
+        } else if ((addr >= 0xC400) && (addr <= 0xC4FF) && !sys->intcxrom && sys->mb.valid) {
+            // Mockingboard
+            if (rw) {
+                // Memory read
+                wdc65C02cpu_set_data(mockingboard_read_byte(&sys->mb, addr & 0xFF));
+            } else {
+                // Memory write, samples up to this tick still use the old PSG registers
+                _apple2e_render_audio(sys, sys->system_ticks + 1);
+                mockingboard_write_byte(&sys->mb, addr & 0xFF, wdc65C02cpu_get_data());
+            }
         } else if ((addr >= 0xC300) && (addr <= 0xC3FF) && !sys->intcxrom) {
             if (rw) {
                 // Memory read
@@ -806,27 +896,16 @@ void apple2e_tick(apple2e_t *sys) {
 
     _apple2e_mem_rw(sys, addr, rw);
 
-    // Update beeper
-    if (beeper_tick(&sys->beeper)) {
-        // New audio sample ready
-        // sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)((sys->beeper.sample * 0.5f + 0.5f) *
-        // 255.0f);
-        sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)(sys->beeper.sample * 255.0f);
-        if (sys->audio.sample_pos == sys->audio.num_samples) {
-            if (sys->audio.callback.func) {
-                // New sample packet is ready
-                sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
-                                         sys->audio.callback.user_data);
-            }
-            sys->audio.sample_pos = 0;
-        }
-    }
-
     // Tick FDC
     if (sys->fdc.valid && (sys->system_ticks & 127) == 0) {
         disk2_fdc_tick(&sys->fdc);
     }
 
+    // Tick Mockingboard VIAs, the PSGs are rendered in blocks up to each write and in apple2e_flush_audio()
+    if (sys->mb.valid && (sys->system_ticks & (MOCKINGBOARD_TICK_STEP - 1)) == 0) {
+        wdc65C02cpu_set_irq(mockingboard_tick(&sys->mb));
+    }
+
     if (sys->flash_timer_ticks > 0) {
         sys->flash_timer_ticks--;
         if (sys->flash_timer_ticks == 0) {
@@ -843,6 +922,51 @@ void apple2e_tick(apple2e_t *sys) {
     sys->system_ticks++;
 }
 
+static void _apple2e_render_audio(apple2e_t *sys, uint32_t end_tick) {
+    resampler_level_t samples[32];
+    resampler_level_t mb_samples[32];
+    int num_samples;
+    do {
+        num_samples = beeper_flush(&sys->beeper, end_tick, samples, 32);
+        if (sys->mb.valid) {
+            // The PSGs share the speaker's output clock, rendered up to the same tick they give as many samples
+            const int n = mockingboard_render(&sys->mb, end_tick, mb_samples, 32);
+            CHIPS_ASSERT(n == num_samples);
+            (void)n;
+        }
+        for (int i = 0; i < num_samples; i++) {
+            // Band-limited steps ring past the speaker levels, keep them in range
+            resampler_level_t s =
+                resampler_mul(samples[i], RESAMPLER_LEVEL(2.0f / 3.0f)) + RESAMPLER_LEVEL(1.0f / 6.0f);
+            if (sys->mb.valid) {
+                s = resampler_mul(s + mb_samples[i], RESAMPLER_LEVEL(0.5f));
+            }
+            sys->audio.sample_buffer[sys->audio.sample_pos++] = resampler_to_u8(s);
+            if (sys->audio.sample_pos == sys->audio.num_samples) {
+                if (sys->audio.callback.func) {
+                    // New sample packet is ready
+                    sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
+                                             sys->audio.callback.user_data);
+                }
+                sys->audio.sample_pos = 0;
+            }
+        }
+    } while (num_samples == 32);
+}
+
+void apple2e_flush_audio(apple2e_t *sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    _apple2e_render_audio(sys, sys->system_ticks);
+}
+
+void apple2e_set_audio_rate_adjust(apple2e_t *sys, int32_t ppm) {
+    CHIPS_ASSERT(sys && sys->valid);
+    resampler_set_rate_adjust(&sys->beeper.resampler, ppm);
+    if (sys->mb.valid) {
+        mockingboard_set_rate_adjust(&sys->mb, ppm);
+    }
+}
+
 uint32_t apple2e_exec(apple2e_t *sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
     uint32_t num_ticks = clk_us_to_ticks(APPLE2E_FREQUENCY, micro_seconds);
@@ -859,8 +983,11 @@ uint32_t apple2e_exec(apple2e_t *sys, uint32_t micro_seconds) {
             sys->debug.callback.func(sys->debug.callback.user_data, 0);
         }
     }
+    apple2e_flush_audio(sys);
     // kbd_update(&sys->kbd, micro_seconds);
+#if APPLE2E_FRAMEBUFFER
     apple2e_screen_update(sys);
+#endif
 
     // printf("executed %d ticks\n", num_ticks);
     return num_ticks;
@@ -966,10 +1093,7 @@ void apple2e_key_down(apple2e_t *sys, int key_code) {
         case 0x142:  // F9
         {
             if (sys->fdc.valid) {
-                uint8_t index = key_code - 0x13A;
-                if (CHIPS_ARRAY_SIZE(apple2_nib_images) > index) {
-                    disk2_fdd_insert_disk(&sys->fdc.fdd[0], apple2_nib_images[index]);
-                }
+                _apple2e_insert_floppy(sys, key_code - 0x13A);
             }
             break;
         }
@@ -1019,6 +1143,7 @@ uint32_t apple2e_save_snapshot(apple2e_t *sys, apple2e_t *dst) {
     chips_audio_callback_snapshot_onsave(&dst->audio.callback);
     // m6502_snapshot_onsave(&dst->cpu);
     disk2_fdc_snapshot_onsave(&dst->fdc);
+    mockingboard_snapshot_onsave(&dst->mb);
     mem_snapshot_onsave(&dst->mem, sys);
     return APPLE2E_SNAPSHOT_VERSION;
 }
@@ -1034,6 +1159,7 @@ bool apple2e_load_snapshot(apple2e_t *sys, uint32_t version, apple2e_t *src) {
     chips_audio_callback_snapshot_onload(&im.audio.callback, &sys->audio.callback);
     // m6502_snapshot_onload(&im.cpu, &sys->cpu);
     disk2_fdc_snapshot_onload(&im.fdc, &sys->fdc);
+    mockingboard_snapshot_onload(&im.mb, &sys->mb);
     mem_snapshot_onload(&im.mem, sys);
     *sys = im;
     return true;
@@ -1101,6 +1227,25 @@ static void _apple2e_render_line_color(uint8_t *out, uint16_t *in, int start_col
     }
 }
 
+// Composite dot stream, 80 column modes are one dot late like in _apple2e_render_line_color()
+static void _apple2e_render_line_composite(uint8_t *out, uint16_t *in, int start_col, int stop_col, bool is_80col) {
+    uint32_t w = in[start_col] << is_80col;
+
+    for (int col = start_col; col < stop_col; col++) {
+        if (col + 1 < 40) {
+            w += in[col + 1] << (14 + is_80col);
+        }
+
+        for (int b = 0; b < 7; b++) {
+            uint8_t c1 = (w & 1) ? 15 : 0;
+            w >>= 1;
+            uint8_t c2 = (w & 1) ? 15 : 0;
+            w >>= 1;
+            out[col * 7 + b] = (c1 << 4) | (c2 & 0xF);
+        }
+    }
+}
+
 static uint8_t _apple2e_get_text_character(apple2e_t *sys, uint8_t code, uint16_t row) {
     uint8_t invert_mask = 0x7F;
 
@@ -1127,7 +1272,135 @@ static uint8_t _apple2e_get_text_character(apple2e_t *sys, uint8_t code, uint16_
     return bits;
 }
 
+static void _apple2e_render_lores_line(apple2e_t *sys, uint16_t row, uint8_t *p) {
+    bool _double = sys->dhires && sys->_80col;
+
+    uint16_t start_address = sys->page2 && !sys->_80store ? 0x0800 : 0x0400;
+    uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
+    uint8_t *vram_row = &sys->ram[address];
+    uint8_t *vaux_row = &sys->aux_ram[address];
+
+#define NIBBLE(byte) (((byte) >> (row & 4)) & 0x0F)
+    for (int col = 0; col < 40; col++) {
+        uint8_t c;
+        if (sys->composite) {
+            // The color pattern repeats every 4 dots, double lores takes the first 7 dots from aux
+            uint8_t c_aux = _double ? _apple2e_rotl4(NIBBLE(vaux_row[col]), 1) : NIBBLE(vram_row[col]);
+            uint8_t c_main = NIBBLE(vram_row[col]);
+            for (int x = col * 14; x < col * 14 + 14; x += 2) {
+                c = (x - col * 14 < 7) ? c_aux : c_main;
+                uint8_t c2 = (x + 1 - col * 14 < 7) ? c_aux : c_main;
+                *p++ = (((c >> (x & 3)) & 1) ? 0xF0 : 0) | (((c2 >> ((x + 1) & 3)) & 1) ? 0x0F : 0);
+            }
+        } else if (_double) {
+            c = _apple2e_rotl4(NIBBLE(vaux_row[col]), 1);
+            for (int b = 0; b < 3; b++) {
+                *p = c << 4;
+                *p++ |= c;
+            }
+            *p = c << 4;
+            c = NIBBLE(vram_row[col]);
+            *p++ |= c;
+            for (int b = 0; b < 3; b++) {
+                *p = c << 4;
+                *p++ |= c;
+            }
+        } else {
+            c = NIBBLE(vram_row[col]);
+            for (int b = 0; b < 7; b++) {
+                *p = c << 4;
+                *p++ |= c;
+            }
+        }
+    }
+#undef NIBBLE
+}
+
+static void _apple2e_render_text_line(apple2e_t *sys, uint16_t row, uint8_t *out) {
+    uint16_t start_address = sys->page2 && !sys->_80store ? 0x0800 : 0x0400;
+    uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
+    uint8_t *vram_row = &sys->ram[address];
+    uint8_t *vaux_row = &sys->aux_ram[address];
+
+    uint16_t words[40];
+
+    for (int col = 0; col < 40; col++) {
+        if (sys->_80col) {
+            words[col] = _apple2e_get_text_character(sys, vaux_row[col], row & 7) +
+                         (_apple2e_get_text_character(sys, vram_row[col], row & 7) << 7);
+        } else {
+            words[col] = _apple2e_double_7_bits(_apple2e_get_text_character(sys, vram_row[col], row & 7));
+        }
+    }
+
+    _apple2e_render_line_monochrome(out, words, 0, 40);
+}
+
+static void _apple2e_render_dhgr_line(apple2e_t *sys, uint16_t row, uint8_t *out) {
+    uint16_t start_address = sys->page2 && !sys->_80store ? 0x4000 : 0x2000;
+    uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
+    uint8_t *vram_row = &sys->ram[address];
+    uint8_t *vaux_row = &sys->aux_ram[address];
+
+    uint16_t words[40];
+
+    for (int col = 0; col < 40; col++) {
+        words[col] = ((vaux_row[col] & 0x7F) | ((vram_row[col] & 0x7F) << 7)) & 0x3FFF;
+    }
+
+    if (sys->composite) {
+        _apple2e_render_line_composite(out, words, 0, 40, true);
+    } else {
+        _apple2e_render_line_color(out, words, 0, 40, true);
+    }
+}
+
+static void _apple2e_render_hgr_line(apple2e_t *sys, uint16_t row, uint8_t *out) {
+    uint16_t start_address = sys->page2 && !sys->_80store ? 0x4000 : 0x2000;
+    uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
+    uint8_t *vram_row = &sys->ram[address];
+
+    uint16_t words[40];
+
+    uint16_t last_output_bit = 0;
+
+    for (int col = 0; col < 40; col++) {
+        uint16_t w = _apple2e_double_7_bits(vram_row[col] & 0x7F);
+        if (vram_row[col] & 0x80) {
+            w = (w << 1 | last_output_bit) & 0x3FFF;
+        };
+        words[col] = w;
+        last_output_bit = w >> 13;
+    }
+
+    if (sys->composite) {
+        _apple2e_render_line_composite(out, words, 0, 40, false);
+    } else {
+        _apple2e_render_line_color(out, words, 0, 40, false);
+    }
+}
+
+// Reads only RAM and the mode switches, so it can run at scan-out time without a framebuffer
+void apple2e_render_line(apple2e_t *sys, int y, uint8_t *out) {
+    CHIPS_ASSERT(sys && sys->valid && out && (y >= 0) && (y < APPLE2E_SCREEN_HEIGHT));
+    if (sys->text || (sys->mixed && (y >= 160))) {
+        _apple2e_render_text_line(sys, y, out);
+    } else if (sys->hires) {
+        if (sys->dhires && sys->_80col) {
+            _apple2e_render_dhgr_line(sys, y, out);
+        } else {
+            _apple2e_render_hgr_line(sys, y, out);
+        }
+    } else {
+        _apple2e_render_lores_line(sys, y, out);
+    }
+}
+
+#if APPLE2E_FRAMEBUFFER
+// Rows are only fetched to be rendered, so flag them as rewritten and showing their own row here
 static uint8_t *_apple2e_get_fb_addr(apple2e_t *sys, uint16_t row) {
+    chips_fb_dirty_set(sys->fb_dirty_rows, row);
+    sys->fb_line[row] = row;
     return &sys->fb[row * (APPLE2E_SCREEN_WIDTH / 2)];
 }
 
@@ -1136,49 +1409,21 @@ static void _apple2e_lores_update(apple2e_t *sys, uint16_t begin_row, uint16_t e
         return;
     }
 
-    bool _double = sys->dhires && sys->_80col;
-
-    uint16_t start_address = sys->page2 && !sys->_80store ? 0x0800 : 0x0400;
-
     uint16_t start_row = (begin_row / 8) * 8;
     uint16_t stop_row = ((end_row / 8) + 1) * 8;
 
     for (int row = start_row; row < stop_row; row += 4) {
-        uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
-        uint8_t *vram_row = &sys->ram[address];
-        uint8_t *vaux_row = &sys->aux_ram[address];
+        _apple2e_render_lores_line(sys, row, _apple2e_get_fb_addr(sys, row));
 
-#define NIBBLE(byte) (((byte) >> (row & 4)) & 0x0F)
-        uint8_t *p = _apple2e_get_fb_addr(sys, row);
-
-        for (int col = 0; col < 40; col++) {
-            uint8_t c;
-            if (_double) {
-                c = _apple2e_rotl4(NIBBLE(vaux_row[col]), 1);
-                for (int b = 0; b < 3; b++) {
-                    *p = c << 4;
-                    *p++ |= c;
-                }
-                *p = c << 4;
-                c = NIBBLE(vram_row[col]);
-                *p++ |= c;
-                for (int b = 0; b < 3; b++) {
-                    *p = c << 4;
-                    *p++ |= c;
-                }
+        for (int y = 1; y < 4; y++) {
+            if (sys->shared_lines) {
+                // All 4 lines of a lores block are equal, point them to the rendered one
+                sys->fb_line[row + y] = row;
+                chips_fb_dirty_set(sys->fb_dirty_rows, row + y);
             } else {
-                c = NIBBLE(vram_row[col]);
-                for (int b = 0; b < 7; b++) {
-                    *p = c << 4;
-                    *p++ |= c;
-                }
+                memcpy(_apple2e_get_fb_addr(sys, row + y), _apple2e_get_fb_addr(sys, row), 40 * 7);
             }
         }
-#undef NIBBLE
-
-        for (int y = 1; y < 4; y++) {
-            memcpy(_apple2e_get_fb_addr(sys, row + y), _apple2e_get_fb_addr(sys, row), 40 * 7);
-        }
     }
 
     if (!sys->page2) {
@@ -1193,28 +1438,11 @@ static void _apple2e_text_update(apple2e_t *sys, uint16_t begin_row, uint16_t en
         return;
     }
 
-    uint16_t start_address = sys->page2 && !sys->_80store ? 0x0800 : 0x0400;
-
     uint16_t start_row = (begin_row / 8) * 8;
     uint16_t stop_row = ((end_row / 8) + 1) * 8;
 
     for (int row = start_row; row < stop_row; row++) {
-        uint16_t address = start_address + ((((row / 8) & 0x07) << 7) | (((row / 8) & 0x18) * 5));
-        uint8_t *vram_row = &sys->ram[address];
-        uint8_t *vaux_row = &sys->aux_ram[address];
-
-        uint16_t words[40];
-
-        for (int col = 0; col < 40; col++) {
-            if (sys->_80col) {
-                words[col] = _apple2e_get_text_character(sys, vaux_row[col], row & 7) +
-                             (_apple2e_get_text_character(sys, vram_row[col], row & 7) << 7);
-            } else {
-                words[col] = _apple2e_double_7_bits(_apple2e_get_text_character(sys, vram_row[col], row & 7));
-            }
-        }
-
-        _apple2e_render_line_monochrome(_apple2e_get_fb_addr(sys, row), words, 0, 40);
+        _apple2e_render_text_line(sys, row, _apple2e_get_fb_addr(sys, row));
     }
 
     if (!sys->page2) {
@@ -1229,20 +1457,8 @@ static void _apple2e_dhgr_update(apple2e_t *sys, uint16_t begin_row, uint16_t en
         return;
     }
 
-    uint16_t start_address = sys->page2 && !sys->_80store ? 0x4000 : 0x2000;
-
     for (int row = begin_row; row <= end_row; row++) {
-        uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
-        uint8_t *vram_row = &sys->ram[address];
-        uint8_t *vaux_row = &sys->aux_ram[address];
-
-        uint16_t words[40];
-
-        for (int col = 0; col < 40; col++) {
-            words[col] = ((vaux_row[col] & 0x7F) | ((vram_row[col] & 0x7F) << 7)) & 0x3FFF;
-        }
-
-        _apple2e_render_line_color(_apple2e_get_fb_addr(sys, row), words, 0, 40, true);
+        _apple2e_render_dhgr_line(sys, row, _apple2e_get_fb_addr(sys, row));
     }
 
     if (!sys->page2) {
@@ -1257,26 +1473,8 @@ static void _apple2e_hgr_update(apple2e_t *sys, uint16_t begin_row, uint16_t end
         return;
     }
 
-    uint16_t start_address = sys->page2 && !sys->_80store ? 0x4000 : 0x2000;
-
     for (int row = begin_row; row <= end_row; row++) {
-        uint32_t address = start_address + (((row / 8) & 0x07) << 7) + (((row / 8) & 0x18) * 5) + ((row & 7) << 10);
-        uint8_t *vram_row = &sys->ram[address];
-
-        uint16_t words[40];
-
-        uint16_t last_output_bit = 0;
-
-        for (int col = 0; col < 40; col++) {
-            uint16_t w = _apple2e_double_7_bits(vram_row[col] & 0x7F);
-            if (vram_row[col] & 0x80) {
-                w = (w << 1 | last_output_bit) & 0x3FFF;
-            };
-            words[col] = w;
-            last_output_bit = w >> 13;
-        }
-
-        _apple2e_render_line_color(_apple2e_get_fb_addr(sys, row), words, 0, 40, false);
+        _apple2e_render_hgr_line(sys, row, _apple2e_get_fb_addr(sys, row));
     }
 
     if (!sys->page2) {
@@ -1307,5 +1505,70 @@ void apple2e_screen_update(apple2e_t *sys) {
         _apple2e_text_update(sys, text_start_row, 191);
     }
 }
+#endif  // APPLE2E_FRAMEBUFFER
+
+void apple2e_set_composite(apple2e_t *sys, bool composite) {
+    CHIPS_ASSERT(sys && sys->valid);
+    if (sys->composite != composite) {
+        sys->composite = composite;
+        sys->text_page1_dirty = sys->text_page2_dirty = true;
+        sys->hires_page1_dirty = sys->hires_page2_dirty = true;
+    }
+}
+
+// Screen code to ASCII, following the character set mapping of _apple2e_get_text_character()
+static char _apple2e_text_ascii(apple2e_t *sys, uint8_t code, uint8_t *attrs) {
+    *attrs = 0;
+    if (code < 0x40) {
+        *attrs = CHIPS_TEXT_INVERSE;
+        code &= 0x3F;
+    } else if (code < 0x80) {
+        if (!sys->altcharset) {
+            *attrs = CHIPS_TEXT_FLASH;
+            code &= 0x3F;
+        } else if (code < 0x60) {
+            // MouseText, reported with the uppercase code it replaces
+            *attrs = CHIPS_TEXT_ALT;
+            return (char)code;
+        } else {
+            *attrs = CHIPS_TEXT_INVERSE;
+            return (char)code;
+        }
+    } else {
+        code &= 0x7F;
+    }
+    return (char)((code < 0x20) ? (code + 0x40) : code);
+}
+
+bool apple2e_text_screen(apple2e_t *sys, chips_text_screen_t *screen) {
+    CHIPS_ASSERT(sys && sys->valid && screen);
+    if (!sys->text && !sys->mixed) {
+        return false;
+    }
+
+    screen->columns = sys->_80col ? 80 : 40;
+    screen->rows = 24;
+    screen->first_row = sys->text ? 0 : 20;
+
+    uint16_t start_address = sys->page2 && !sys->_80store ? 0x0800 : 0x0400;
+
+    for (int row = 0; row < 24; row++) {
+        uint16_t address = start_address + ((row & 0x07) << 7) + ((row & 0x18) * 5);
+        for (int col = 0; col < screen->columns; col++) {
+            // 80 columns interleave aux and main memory, aux first
+            uint8_t code = !sys->_80col ? sys->ram[address + col]
+                           : (col & 1)  ? sys->ram[address + (col >> 1)]
+                                        : sys->aux_ram[address + (col >> 1)];
+            if (row < screen->first_row) {
+                screen->chars[row][col] = ' ';
+                screen->attrs[row][col] = 0;
+            } else {
+                screen->chars[row][col] = _apple2e_text_ascii(sys, code, &screen->attrs[row][col]);
+            }
+            screen->colors[row][col] = 0x0F;
+        }
+    }
+    return true;
+}
 
 #endif  // CHIPS_IMPL
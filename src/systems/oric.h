@@ -23,6 +23,7 @@
     - chips/chips_common.h
     - chips/wdc65C02cpu.h
     - chips/mos6522via.h
+    - chips/resampler.h
     - chips/ay38910psg.h
     - chips/kbd.h
     - chips/mem.h
@@ -68,17 +69,29 @@ extern "C" {
 #endif
 
 // Bump snapshot version when oric_t memory layout changes
-#define ORIC_SNAPSHOT_VERSION (1)
+#define ORIC_SNAPSHOT_VERSION (12)
 
 #define ORIC_FREQUENCY             (1000000)  // 1 MHz
 #define ORIC_MAX_AUDIO_SAMPLES     (2048)     // Max number of audio samples in internal sample buffer
-#define ORIC_DEFAULT_AUDIO_SAMPLES (2048)     // Default number of samples in internal sample buffer
+#define ORIC_DEFAULT_AUDIO_SAMPLES (256)       // Default number of samples in internal sample buffer
 #define ORIC_MAX_TAPE_SIZE         (1 << 16)  // Max size of tape file in bytes
 
 #define ORIC_SCREEN_WIDTH     240  // (240)
 #define ORIC_SCREEN_HEIGHT    224  // (224)
 #define ORIC_FRAMEBUFFER_SIZE ((ORIC_SCREEN_WIDTH / 2) * ORIC_SCREEN_HEIGHT)
 
+#ifndef ORIC_EXTERNAL_FRAMEBUFFER
+// Set to 1 to render into a frontend-owned buffer (e.g. the back buffer of util/triplebuf.h) set in fb
+#define ORIC_EXTERNAL_FRAMEBUFFER (0)
+#endif  // ORIC_EXTERNAL_FRAMEBUFFER
+
+#define ORIC_SCREEN_COLUMNS (40)                   // Character cells per line
+#define ORIC_SCREEN_ROWS    (28)                   // Text rows, 8 lines each
+#define ORIC_LINE_CLEAN     (ORIC_SCREEN_COLUMNS)  // line_dirty_col value of an up-to-date line
+#define ORIC_CHARSET_BANKS  (4)                    // Text and HIRES mode standard / alternate charsets
+#define ORIC_FRAME_TICKS    (312 * 64)             // 50 Hz frame, 312 lines of 64 us
+#define ORIC_BLINK_TICKS    (32 * ORIC_FRAME_TICKS)  // Blink phase duration, 32 frames
+
 // Config parameters for oric_init()
 typedef struct {
     bool td_enabled;      // Set to true to enable tape drive emulation
@@ -113,12 +126,37 @@ typedef struct {
     uint8_t* rom;
     uint8_t* boot_rom;
 
-    int blink_counter;
+    bool blink_state;             // Current blink phase, true when blinking cells are hidden
+    uint32_t blink_toggle_ticks;  // system_ticks value of the next blink phase change
     uint8_t pattr;
 
     uint8_t reserved[3];
+#if ORIC_EXTERNAL_FRAMEBUFFER
+    uint8_t* fb;  // ORIC_FRAMEBUFFER_SIZE bytes holding the last rendered frame, set by the frontend
+#else
     uint8_t fb[ORIC_FRAMEBUFFER_SIZE];
-    bool screen_dirty;
+#endif
+    uint32_t fb_dirty_rows[CHIPS_FB_DIRTY_WORDS(ORIC_SCREEN_HEIGHT)];  // fb rows rewritten, cleared by the frontend
+    bool screen_dirty;  // Set if any line needs to be re-rendered
+
+    // Per-line render state, serial attributes make a change affect the rest of the line only
+    uint8_t line_dirty_col[ORIC_SCREEN_HEIGHT];  // First column to re-render, ORIC_LINE_CLEAN if up to date
+    uint8_t line_pattr[ORIC_SCREEN_HEIGHT];      // Video mode attributes at the start of each line
+    uint8_t line_flags[ORIC_SCREEN_HEIGHT];      // What the line read during its last render
+    uint8_t line_blink_col[ORIC_SCREEN_HEIGHT];  // First blinking column, ORIC_LINE_CLEAN if none
+
+    // Glyph usage index: text rows (bit mask) rendered with each character of each charset bank.
+    // Bits are only cleared when the glyph is redefined, so the index may over-approximate.
+    uint32_t glyph_rows[ORIC_CHARSET_BANKS][128];
+
+    // Render-time counters, never reset by the emulator
+    struct {
+        uint32_t updates;       // Screen updates that rendered at least one line
+        uint32_t lines;         // Lines (or line remainders) rendered
+        uint32_t cells;         // Character cells drawn
+        uint32_t glyph_writes;  // Writes to charset memory
+        uint32_t glyph_rows;    // Text rows invalidated by charset writes
+    } render_stats;
 
     uint16_t extension;
 
@@ -143,6 +181,8 @@ void oric_tick(oric_t* sys);
 
 // tick Oric instance for a given number of microseconds, return number of executed ticks
 uint32_t oric_exec(oric_t* sys, uint32_t micro_seconds);
+// render the PSG output up to the current tick into the audio sample buffer, call after running oric_tick()
+void oric_flush_audio(oric_t* sys);
 // send a key-down event to the Oric Atmos
 void oric_key_down(oric_t* sys, int key_code);
 // send a key-up event to the Oric Atmos
@@ -153,6 +193,8 @@ uint32_t oric_save_snapshot(oric_t* sys, oric_t* dst);
 bool oric_load_snapshot(oric_t* sys, uint32_t version, oric_t* src);
 
 void oric_screen_update(oric_t* sys);
+// decode the text screen and its serial attributes from RAM without rendering
+bool oric_text_screen(oric_t* sys, chips_text_screen_t* screen);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -177,6 +219,55 @@ static void _oric_init_key_map(oric_t* sys);
 #define LATTR_DSIZE (0x02)
 #define LATTR_BLINK (0x04)
 
+// Line flags, recorded while rendering to map video memory writes to lines
+#define _ORIC_LINE_TEXT          (0x01)  // Line reads character codes from the text screen
+#define _ORIC_LINE_HIRES         (0x02)  // Line reads pixel data from the HIRES screen
+#define _ORIC_LINE_CHARSET_SHIFT (4)     // Bits 4..7: charset banks used by the line
+
+// Charset banks: standard / alternate text charsets and their HIRES mode counterparts
+static const uint16_t _oric_charset_base[4] = {0xB400, 0xB800, 0x9800, 0x9C00};
+
+// Packed output bytes (6 pixels, 4 bits each) of a cell, indexed by 6-bit pattern, foreground and background color
+static uint8_t _oric_cell_lut[64 * 8 * 8][3];
+
+static void _oric_init_cell_lut(void) {
+    for (int pat = 0; pat < 64; pat++) {
+        for (int fgcol = 0; fgcol < 8; fgcol++) {
+            for (int bgcol = 0; bgcol < 8; bgcol++) {
+                uint8_t* out = _oric_cell_lut[(pat << 6) | (fgcol << 3) | bgcol];
+                for (int i = 0; i < 3; i++) {
+                    uint8_t c1 = (pat & (0x20 >> (i * 2))) ? fgcol : bgcol;
+                    uint8_t c2 = (pat & (0x10 >> (i * 2))) ? fgcol : bgcol;
+                    out[i] = (c1 << 4) | c2;
+                }
+            }
+        }
+    }
+}
+
+// Sector images, images/oric_images.h defines ORIC_DSK_IMAGES when it lists oric_dsk_images[]
+#ifndef ORIC_DSK_IMAGES
+#define ORIC_DSK_IMAGES
+#define ORIC_NUM_DSK_IMAGES (0)
+static const disk2_nib_dsk_image_t* const oric_dsk_images = NULL;
+#endif
+#ifndef ORIC_NUM_DSK_IMAGES
+#define ORIC_NUM_DSK_IMAGES ((int)CHIPS_ARRAY_SIZE(oric_dsk_images))
+#endif
+
+// Insert floppy image index, counting the NIB images first and then the sector images
+static void _oric_insert_floppy(oric_t* sys, int index) {
+    int num_nib_images = CHIPS_ARRAY_SIZE(oric_nib_images);
+    if (index < num_nib_images) {
+        disk2_fdd_insert_disk(&sys->fdc.fdd[0], oric_nib_images[index]);
+    } else {
+        index -= num_nib_images;
+        if (index < ORIC_NUM_DSK_IMAGES) {
+            disk2_fdd_insert_dsk(&sys->fdc.fdd[0], oric_dsk_images[index].image, oric_dsk_images[index].order);
+        }
+    }
+}
+
 void oric_init(oric_t* sys, const oric_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
     if (desc->debug.callback.func) {
@@ -199,19 +290,26 @@ void oric_init(oric_t* sys, const oric_desc_t* desc) {
 
     wdc65C02cpu_init();
 
+    _oric_init_cell_lut();
+
     mos6522via_init(&sys->via);
     ay38910psg_init(&sys->psg, &(ay38910psg_desc_t){.type = AY38910PSG_TYPE_8912,
                                                     .in_cb = _oric_psg_in,
                                                     .out_cb = _oric_psg_out,
                                                     .magnitude = CHIPS_DEFAULT(desc->audio.volume, 1.0f),
+                                                    .tick_hz = ORIC_FREQUENCY,
+                                                    .sound_hz = CHIPS_DEFAULT(desc->audio.sample_rate, 22050),
                                                     .user_data = sys});
 
     // setup memory map and keyboard matrix
     _oric_init_memorymap(sys);
     _oric_init_key_map(sys);
 
-    sys->blink_counter = 0;
+    sys->blink_state = false;
+    sys->blink_toggle_ticks = ORIC_BLINK_TICKS;
     sys->pattr = 0;
+    memset(sys->line_dirty_col, 0, sizeof(sys->line_dirty_col));
+    sys->screen_dirty = true;
 
     sys->extension = 0;
 
@@ -223,9 +321,7 @@ void oric_init(oric_t* sys, const oric_desc_t* desc) {
     // Optionally setup floppy disk controller
     if (desc->fdc_enabled) {
         disk2_fdc_init(&sys->fdc);
-        if (CHIPS_ARRAY_SIZE(oric_nib_images) > 0) {
-            disk2_fdd_insert_disk(&sys->fdc.fdd[0], oric_nib_images[0]);
-        }
+        _oric_insert_floppy(sys, 0);
     }
 }
 
@@ -258,6 +354,64 @@ void oric_reset(oric_t* sys) {
     wdc65C02cpu_reset();
 }
 
+static inline void _oric_mark_line_dirty(oric_t* sys, int y, uint8_t col) {
+    if (col < sys->line_dirty_col[y]) {
+        sys->line_dirty_col[y] = col;
+    }
+    sys->screen_dirty = true;
+}
+
+// Invalidate the text rows using a redefined glyph, they register their glyphs again when rendered
+static void _oric_glyph_write(oric_t* sys, int bank, uint8_t code) {
+    sys->render_stats.glyph_writes++;
+    uint32_t rows = sys->glyph_rows[bank][code];
+    if (rows == 0) {
+        return;
+    }
+    sys->glyph_rows[bank][code] = 0;
+    uint8_t bank_flag = 1 << (_ORIC_LINE_CHARSET_SHIFT + bank);
+    for (int row = 0; rows != 0; row++, rows >>= 1) {
+        if (rows & 1) {
+            sys->render_stats.glyph_rows++;
+            for (int y = row * 8; y < row * 8 + 8; y++) {
+                if (sys->line_flags[y] & bank_flag) {
+                    _oric_mark_line_dirty(sys, y, 0);
+                }
+            }
+        }
+    }
+}
+
+// Map a write to video memory ($9800-$BFDF) to the lines that need to be re-rendered
+static void _oric_screen_write(oric_t* sys, uint16_t addr) {
+    if (addr >= 0xBB80) {
+        // Text screen, 28 rows of 8 lines each
+        uint16_t offset = addr - 0xBB80;
+        uint8_t row = offset / ORIC_SCREEN_COLUMNS;
+        uint8_t col = offset - row * ORIC_SCREEN_COLUMNS;
+        for (int y = row * 8; y < row * 8 + 8; y++) {
+            if (sys->line_flags[y] & _ORIC_LINE_TEXT) {
+                _oric_mark_line_dirty(sys, y, col);
+            }
+        }
+    }
+    if ((addr >= 0xA000) && (addr < 0xA000 + 200 * ORIC_SCREEN_COLUMNS)) {
+        // HIRES screen, 200 lines
+        uint16_t offset = addr - 0xA000;
+        uint8_t y = offset / ORIC_SCREEN_COLUMNS;
+        if (sys->line_flags[y] & _ORIC_LINE_HIRES) {
+            _oric_mark_line_dirty(sys, y, offset - y * ORIC_SCREEN_COLUMNS);
+        }
+    }
+    if (addr < 0xA000) {
+        // HIRES mode charsets
+        _oric_glyph_write(sys, 2 + ((addr >> 10) & 1), (addr >> 3) & 0x7F);
+    } else if ((addr >= 0xB400) && (addr < 0xBC00)) {
+        // Text mode charsets
+        _oric_glyph_write(sys, (addr - 0xB400) >> 10, (addr >> 3) & 0x7F);
+    }
+}
+
 static void _oric_mem_rw(oric_t* sys, uint16_t addr, bool rw) {
     if ((addr >= 0x0300) && (addr <= 0x03FF)) {
         // Memory-mapped IO area
@@ -331,7 +485,7 @@ static void _oric_mem_rw(oric_t* sys, uint16_t addr, bool rw) {
             mem_wr(&sys->mem, addr, wdc65C02cpu_get_data());
 
             if (addr >= 0x9800 && addr <= 0xBFDF) {
-                sys->screen_dirty = true;
+                _oric_screen_write(sys, addr);
             }
         }
     }
@@ -339,6 +493,31 @@ static void _oric_mem_rw(oric_t* sys, uint16_t addr, bool rw) {
 
 static uint8_t _last_motor_state = 0;
 
+static void _oric_render_audio(oric_t* sys, uint32_t end_tick) {
+    resampler_level_t samples[32];
+    int num_samples;
+    do {
+        num_samples = ay38910psg_render(&sys->psg, end_tick, samples, 32);
+        for (int i = 0; i < num_samples; i++) {
+            // Band-limited steps ring past the channel levels, keep them in range
+            sys->audio.sample_buffer[sys->audio.sample_pos++] = resampler_to_u8(samples[i]);
+            if (sys->audio.sample_pos == sys->audio.num_samples) {
+                if (sys->audio.callback.func) {
+                    // New sample packet is ready
+                    sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
+                                             sys->audio.callback.user_data);
+                }
+                sys->audio.sample_pos = 0;
+            }
+        }
+    } while (num_samples == 32);
+}
+
+void oric_flush_audio(oric_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    _oric_render_audio(sys, sys->system_ticks);
+}
+
 void oric_tick(oric_t* sys) {
     uint16_t addr;
     bool rw;
@@ -347,31 +526,7 @@ void oric_tick(oric_t* sys) {
 
     _oric_mem_rw(sys, addr, rw);
 
-    // Tick PSG
-    if ((sys->system_ticks & 63) == 0) {
-        ay38910psg_tick_channels(&sys->psg);
-    }
-
-    if ((sys->system_ticks & 127) == 0) {
-        ay38910psg_tick_envelope_generator(&sys->psg);
-    }
-
-    static uint8_t t1 = 0;
-    t1++;
-    if (t1 == 46) {
-        ay38910psg_tick_sample_generator(&sys->psg);
-        // sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)((sys->psg.sample * 0.5f + 0.5f) * 255.0f);
-        sys->audio.sample_buffer[sys->audio.sample_pos++] = (uint8_t)(sys->psg.sample * 255.0f);
-        if (sys->audio.sample_pos == sys->audio.num_samples) {
-            if (sys->audio.callback.func) {
-                // New sample packet is ready
-                sys->audio.callback.func(sys->audio.sample_buffer, sys->audio.num_samples,
-                                         sys->audio.callback.user_data);
-            }
-            sys->audio.sample_pos = 0;
-        }
-        t1 = 0;
-    }
+    // The PSG is rendered in blocks, up to each register write and in oric_flush_audio()
 
     // Tick FDC
     if (sys->fdc.valid && (sys->system_ticks & 127) == 0) {
@@ -388,6 +543,8 @@ void oric_tick(oric_t* sys) {
             if (mos6522via_get_ca2(&sys->via)) {
                 ay38910psg_latch_address(&sys->psg, psg_data);
             } else {
+                // Samples up to this tick still use the old register values
+                _oric_render_audio(sys, sys->system_ticks + 1);
                 ay38910psg_write(&sys->psg, psg_data);
             }
         }
@@ -456,49 +613,181 @@ static uint8_t _oric_psg_in(int port_id, void* user_data) {
     return 0xFF;
 }
 
+// Render line y starting at column x0, return the video mode attributes at the end of the line.
+// Columns before x0 are only decoded for their serial attributes.
+static uint8_t _oric_render_line(oric_t* sys, int y, int x0) {
+    // Line attributes and current colors
+    uint8_t pattr = sys->line_pattr[y];
+    uint8_t lattr = 0;
+    uint8_t fgcol = 7;
+    uint8_t bgcol = 0;
+    uint8_t flags = 0;
+    uint8_t blink_col = ORIC_LINE_CLEAN;
+    bool blink_state = sys->blink_state;
+
+    uint8_t* p = &sys->fb[y * (ORIC_SCREEN_WIDTH / 2) + x0 * 3];
+
+    for (int x = 0; x < ORIC_SCREEN_COLUMNS; x++) {
+        // Lookup the byte and, if needed, the pattern data
+        uint8_t ch, pat = 0;
+        if ((pattr & PATTR_HIRES) && y < 200) {
+            ch = pat = sys->ram[0xA000 + y * 40 + x];
+            flags |= _ORIC_LINE_HIRES;
+        } else {
+            ch = sys->ram[0xBB80 + (y >> 3) * 40 + x];
+            int bank = ((pattr & PATTR_HIRES) ? 2 : 0) | (lattr & LATTR_ALT);
+            flags |= _ORIC_LINE_TEXT | (1 << (_ORIC_LINE_CHARSET_SHIFT + bank));
+            if (x >= x0) {
+                int off = (lattr & LATTR_DSIZE ? y >> 1 : y) & 7;
+                pat = sys->ram[_oric_charset_base[bank] + (((ch & 0x7F) << 3) | off)];
+                if (ch & 0x60) {
+                    sys->glyph_rows[bank][ch & 0x7F] |= 1u << (y >> 3);
+                }
+            }
+        }
+
+        // Handle state-chaging attributes
+        if (!(ch & 0x60)) {
+            pat = 0x00;
+            switch (ch & 0x18) {
+                case 0x00:
+                    fgcol = ch & 7;
+                    break;
+                case 0x08:
+                    lattr = ch & 7;
+                    break;
+                case 0x10:
+                    bgcol = ch & 7;
+                    break;
+                case 0x18:
+                    pattr = ch & 7;
+                    break;
+            }
+        }
+
+        if ((lattr & LATTR_BLINK) && (blink_col == ORIC_LINE_CLEAN)) {
+            blink_col = x;
+        }
+
+        if (x < x0) {
+            continue;
+        }
+
+        // Pick up the colors for the pattern, inverse video flips both colors
+        uint8_t colors = (fgcol << 3) | bgcol;
+        if (ch & 0x80) {
+            colors ^= 0x3F;
+        }
+        // blink
+        if ((lattr & LATTR_BLINK) && blink_state) {
+            colors = (colors & 0x07) * 9;
+        }
+
+        // Draw the pattern
+        const uint8_t* cell = _oric_cell_lut[((pat & 0x3F) << 6) | colors];
+        p[0] = cell[0];
+        p[1] = cell[1];
+        p[2] = cell[2];
+        p += 3;
+    }
+
+    sys->line_flags[y] = flags;
+    sys->line_blink_col[y] = blink_col;
+    chips_fb_dirty_set(sys->fb_dirty_rows, y);
+    sys->line_dirty_col[y] = ORIC_LINE_CLEAN;
+    sys->render_stats.lines++;
+    sys->render_stats.cells += ORIC_SCREEN_COLUMNS - x0;
+    return pattr;
+}
+
+// Advance the blink phase from emulated time, a phase change re-renders the blinking line spans
+static void _oric_blink_update(oric_t* sys) {
+    bool blink_state = sys->blink_state;
+    while ((int32_t)(sys->system_ticks - sys->blink_toggle_ticks) >= 0) {
+        blink_state = !blink_state;
+        sys->blink_toggle_ticks += ORIC_BLINK_TICKS;
+    }
+    if (blink_state != sys->blink_state) {
+        sys->blink_state = blink_state;
+        for (int y = 0; y < ORIC_SCREEN_HEIGHT; y++) {
+            if (sys->line_blink_col[y] != ORIC_LINE_CLEAN) {
+                _oric_mark_line_dirty(sys, y, sys->line_blink_col[y]);
+            }
+        }
+    }
+}
+
 void oric_screen_update(oric_t* sys) {
+    _oric_blink_update(sys);
     if (!sys->screen_dirty) {
         return;
     }
+    sys->screen_dirty = false;
+    sys->render_stats.updates++;
 
-    bool blink_state = sys->blink_counter & 0x20;
-    sys->blink_counter = (sys->blink_counter + 1) & 0x3F;
+    for (int y = 0; y < ORIC_SCREEN_HEIGHT; y++) {
+        if (sys->line_dirty_col[y] == ORIC_LINE_CLEAN) {
+            continue;
+        }
 
-    uint8_t pattr = sys->pattr;
+        uint8_t pattr = _oric_render_line(sys, y, sys->line_dirty_col[y]);
 
-    for (int y = 0; y < 224; y++) {
-        // Line attributes and current colors
-        uint8_t lattr = 0;
-        uint8_t fgcol = 7;
-        uint8_t bgcol = 0;
+        // A video mode attribute change carries over to the following line (and frame)
+        if (y < ORIC_SCREEN_HEIGHT - 1) {
+            if (pattr != sys->line_pattr[y + 1]) {
+                sys->line_pattr[y + 1] = pattr;
+                sys->line_dirty_col[y + 1] = 0;
+            }
+        } else if (pattr != sys->pattr) {
+            sys->pattr = pattr;
+            sys->line_pattr[0] = pattr;
+            _oric_mark_line_dirty(sys, 0, 0);
+        }
+    }
+}
 
-        uint8_t* p = &sys->fb[y * (ORIC_SCREEN_WIDTH / 2)];
+// Return the video mode attributes after a line of screen codes
+static uint8_t _oric_scan_pattr(const uint8_t* codes, uint8_t pattr) {
+    for (int x = 0; x < ORIC_SCREEN_COLUMNS; x++) {
+        if (((codes[x] & 0x60) == 0) && ((codes[x] & 0x18) == 0x18)) {
+            pattr = codes[x] & 7;
+        }
+    }
+    return pattr;
+}
 
-        for (int x = 0; x < 40; x++) {
-            // Lookup the byte and, if needed, the pattern data
-            uint8_t ch, pat;
-            if ((pattr & PATTR_HIRES) && y < 200)
-                ch = pat = sys->ram[0xA000 + y * 40 + x];
+bool oric_text_screen(oric_t* sys, chips_text_screen_t* screen) {
+    CHIPS_ASSERT(sys && sys->valid && screen);
+    screen->columns = ORIC_SCREEN_COLUMNS;
+    screen->rows = ORIC_SCREEN_ROWS;
+    screen->first_row = 0;
 
-            else {
-                ch = sys->ram[0xBB80 + (y >> 3) * 40 + x];
-                int off = (lattr & LATTR_DSIZE ? y >> 1 : y) & 7;
-                const uint8_t* base;
-                if (pattr & PATTR_HIRES)
-                    if (lattr & LATTR_ALT)
-                        base = sys->ram + 0x9C00;
-                    else
-                        base = sys->ram + 0x9800;
-                else if (lattr & LATTR_ALT)
-                    base = sys->ram + 0xB800;
-                else
-                    base = sys->ram + 0xB400;
-                pat = base[((ch & 0x7F) << 3) | off];
+    uint8_t pattr = sys->pattr;
+    for (int row = 0; row < ORIC_SCREEN_ROWS; row++) {
+        const uint8_t* codes = &sys->ram[0xBB80 + row * ORIC_SCREEN_COLUMNS];
+
+        // Rows starting in the HIRES area show graphics, which may still switch the video mode
+        if ((pattr & PATTR_HIRES) && (row * 8 < 200)) {
+            for (int y = row * 8; y < row * 8 + 8; y++) {
+                pattr = _oric_scan_pattr((pattr & PATTR_HIRES) && (y < 200) ? &sys->ram[0xA000 + y * 40] : codes, pattr);
+            }
+            memset(screen->chars[row], ' ', ORIC_SCREEN_COLUMNS);
+            memset(screen->attrs[row], 0, ORIC_SCREEN_COLUMNS);
+            memset(screen->colors[row], 0, ORIC_SCREEN_COLUMNS);
+            if (screen->first_row == row) {
+                screen->first_row = row + 1;
             }
+            continue;
+        }
 
-            // Handle state-chaging attributes
+        uint8_t lattr = 0;
+        uint8_t fgcol = 7;
+        uint8_t bgcol = 0;
+        for (int x = 0; x < ORIC_SCREEN_COLUMNS; x++) {
+            uint8_t ch = codes[x];
+            char c = ' ';
+            uint8_t attrs = 0;
             if (!(ch & 0x60)) {
-                pat = 0x00;
                 switch (ch & 0x18) {
                     case 0x00:
                         fgcol = ch & 7;
@@ -513,40 +802,20 @@ void oric_screen_update(oric_t* sys) {
                         pattr = ch & 7;
                         break;
                 }
+            } else {
+                c = (char)(ch & 0x7F);
+                attrs = ((lattr & LATTR_ALT) ? CHIPS_TEXT_ALT : 0) | ((lattr & LATTR_DSIZE) ? CHIPS_TEXT_DOUBLE : 0) |
+                        ((lattr & LATTR_BLINK) ? CHIPS_TEXT_FLASH : 0);
             }
-
-            // Pick up the colors for the pattern
-            uint8_t c_fgcol = fgcol;
-            uint8_t c_bgcol = bgcol;
-
-            // inverse video
             if (ch & 0x80) {
-                c_bgcol = c_bgcol ^ 0x07;
-                c_fgcol = c_fgcol ^ 0x07;
+                attrs |= CHIPS_TEXT_INVERSE;
             }
-            // blink
-            if ((lattr & LATTR_BLINK) && blink_state) c_fgcol = c_bgcol;
-
-            // Draw the pattern
-            uint8_t c;
-            c = pat & 0x20 ? c_fgcol : c_bgcol;
-            *p = c << 4;
-            c = pat & 0x10 ? c_fgcol : c_bgcol;
-            *p++ |= c;
-            c = pat & 0x08 ? c_fgcol : c_bgcol;
-            *p = c << 4;
-            c = pat & 0x04 ? c_fgcol : c_bgcol;
-            *p++ |= c;
-            c = pat & 0x02 ? c_fgcol : c_bgcol;
-            *p = c << 4;
-            c = pat & 0x01 ? c_fgcol : c_bgcol;
-            *p++ |= c;
+            screen->chars[row][x] = c;
+            screen->attrs[row][x] = attrs;
+            screen->colors[row][x] = fgcol | (bgcol << 4);
         }
     }
-
-    sys->pattr = pattr;
-
-    sys->screen_dirty = false;
+    return true;
 }
 
 uint32_t oric_exec(oric_t* sys, uint32_t micro_seconds) {
@@ -564,6 +833,7 @@ uint32_t oric_exec(oric_t* sys, uint32_t micro_seconds) {
             sys->debug.callback.func(sys->debug.callback.user_data, 0);
         }
     }
+    oric_flush_audio(sys);
     kbd_update(&sys->kbd, micro_seconds);
     oric_screen_update(sys);
     return num_ticks;
@@ -650,13 +920,13 @@ void oric_key_down(oric_t* sys, int key_code) {
         case 0x142:  // F9
         {
             uint8_t index = key_code - 0x13A;
-            int num_nib_images = CHIPS_ARRAY_SIZE(oric_nib_images);
-            if (index < num_nib_images) {
+            int num_disk_images = CHIPS_ARRAY_SIZE(oric_nib_images) + ORIC_NUM_DSK_IMAGES;
+            if (index < num_disk_images) {
                 if (sys->fdc.valid) {
-                    disk2_fdd_insert_disk(&sys->fdc.fdd[0], oric_nib_images[index]);
+                    _oric_insert_floppy(sys, index);
                 }
             } else {
-                index -= num_nib_images;
+                index -= num_disk_images;
                 if (index < CHIPS_ARRAY_SIZE(oric_wave_images)) {
                     if (sys->td.valid) {
                         oric_td_insert_tape(&sys->td, oric_wave_images[index]);
@@ -712,6 +982,12 @@ bool oric_load_snapshot(oric_t* sys, uint32_t version, oric_t* src) {
     oric_td_snapshot_onload(&im.td, &sys->td);
     disk2_fdc_snapshot_onload(&im.fdc, &sys->fdc);
     mem_snapshot_onload(&im.mem, sys);
+#if ORIC_EXTERNAL_FRAMEBUFFER
+    // The frame isn't part of the snapshot, keep rendering into the frontend buffer and redraw it all
+    im.fb = sys->fb;
+    memset(im.line_dirty_col, 0, sizeof(im.line_dirty_col));
+    im.screen_dirty = true;
+#endif
     *sys = im;
     return true;
 }
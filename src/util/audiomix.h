@@ -0,0 +1,134 @@
+#pragma once
+
+// Fixed-point audio mixing kernels
+//
+// Mixes 8-bit unsigned sources (128 is silence, the PWM output format) into
+// a signed 16-bit accumulator with a per-source 8.8 volume, then saturates
+// the sum back to 8 bits. The Pico mixer in audio.c uses it, host frontends
+// can share it.
+//
+// Adding a source computes ((sample - 128) * volume) >> 8 and adds it with
+// signed saturation. Volumes are limited to 0x7FFF so the scaled sample
+// always fits 16 bits. The SSE2 path (x86-64 hosts) works on 16 samples at
+// a time, the portable path is unrolled by 4 for the Cortex-M0+, which has
+// no SIMD but pays for every loop branch. Both give identical results.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Define AUDIOMIX_USE_SSE2 as 0 to build the portable path on SSE2 hosts, the tests check both
+#ifndef AUDIOMIX_USE_SSE2
+#if defined(__SSE2__)
+#define AUDIOMIX_USE_SSE2 (1)
+#else
+#define AUDIOMIX_USE_SSE2 (0)
+#endif
+#endif
+#if AUDIOMIX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUDIOMIX_UNITY_VOLUME (0x0100)  // 1.0 in 8.8 fixed point
+#define AUDIOMIX_MAX_VOLUME   (0x7FFF)  // Just below 128.0
+
+// Set n accumulator samples to silence
+void audiomix_clear(int16_t* acc, int n);
+
+// Add n 8-bit samples scaled by an 8.8 volume to the accumulator, with saturation
+void audiomix_add(int16_t* acc, const uint8_t* src, int n, uint16_t volume);
+
+// Convert n accumulator samples back to 8-bit samples, with saturation
+void audiomix_store(uint8_t* dst, const int16_t* acc, int n);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+static inline int16_t _audiomix_sat16(int32_t v) {
+    return (int16_t)((v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : v);
+}
+
+static inline int16_t _audiomix_mix(int16_t acc, uint8_t s, int32_t volume) {
+    return _audiomix_sat16((int32_t)acc + ((((int32_t)s - 128) * volume) >> 8));
+}
+
+static inline uint8_t _audiomix_sat8(int16_t v) {
+    int32_t s = (int32_t)v + 128;
+    return (uint8_t)((s > 255) ? 255 : (s < 0) ? 0 : s);
+}
+
+void audiomix_clear(int16_t* acc, int n) {
+    CHIPS_ASSERT(acc && (n >= 0));
+    memset(acc, 0, (size_t)n * sizeof(int16_t));
+}
+
+void audiomix_add(int16_t* acc, const uint8_t* src, int n, uint16_t volume) {
+    CHIPS_ASSERT(acc && src && (n >= 0) && (volume <= AUDIOMIX_MAX_VOLUME));
+    int i = 0;
+#if AUDIOMIX_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i vol = _mm_set1_epi16((int16_t)volume);
+    for (; i + 16 <= n; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i x[2] = {_mm_sub_epi16(_mm_unpacklo_epi8(s, zero), bias),
+                        _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), bias)};
+        for (int h = 0; h < 2; h++) {
+            // (x * vol) >> 8 is bits 8..23 of the 32-bit product: the high word's low byte, the low word's high byte
+            __m128i lo = _mm_mullo_epi16(x[h], vol);
+            __m128i hi = _mm_mulhi_epi16(x[h], vol);
+            __m128i scaled = _mm_or_si128(_mm_slli_epi16(hi, 8), _mm_srli_epi16(lo, 8));
+            __m128i* a = (__m128i*)&acc[i + h * 8];
+            _mm_storeu_si128(a, _mm_adds_epi16(_mm_loadu_si128(a), scaled));
+        }
+    }
+#else
+    for (; i + 4 <= n; i += 4) {
+        acc[i + 0] = _audiomix_mix(acc[i + 0], src[i + 0], volume);
+        acc[i + 1] = _audiomix_mix(acc[i + 1], src[i + 1], volume);
+        acc[i + 2] = _audiomix_mix(acc[i + 2], src[i + 2], volume);
+        acc[i + 3] = _audiomix_mix(acc[i + 3], src[i + 3], volume);
+    }
+#endif
+    for (; i < n; i++) {
+        acc[i] = _audiomix_mix(acc[i], src[i], volume);
+    }
+}
+
+void audiomix_store(uint8_t* dst, const int16_t* acc, int n) {
+    CHIPS_ASSERT(dst && acc && (n >= 0));
+    int i = 0;
+#if AUDIOMIX_USE_SSE2
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; i + 16 <= n; i += 16) {
+        __m128i a0 = _mm_adds_epi16(_mm_loadu_si128((const __m128i*)&acc[i]), bias);
+        __m128i a1 = _mm_adds_epi16(_mm_loadu_si128((const __m128i*)&acc[i + 8]), bias);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(a0, a1));
+    }
+#else
+    for (; i + 4 <= n; i += 4) {
+        dst[i + 0] = _audiomix_sat8(acc[i + 0]);
+        dst[i + 1] = _audiomix_sat8(acc[i + 1]);
+        dst[i + 2] = _audiomix_sat8(acc[i + 2]);
+        dst[i + 3] = _audiomix_sat8(acc[i + 3]);
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = _audiomix_sat8(acc[i]);
+    }
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,209 @@
+#pragma once
+
+// Banded post-processing worker pool
+//
+// Splits a frame into horizontal bands and runs a per-band function on a
+// pool of threads, for host builds only (pthreads and C11 atomics). Meant
+// for the expensive output stages (NTSC decoding, 4x scaling with
+// scanlines) when several instances record at the full frame rate.
+//
+// Rows of the emulated framebuffers are independent once rendered (Apple
+// rows have no vertical dependencies, Oric serial attributes are reset at
+// the start of every line), so bands need no synchronization besides the
+// join at the end of bandpool_run(). The calling thread renders bands too,
+// a pool of N threads creates N - 1 workers.
+//
+// fbconv_convert_band() and ntsc_decode_band() take a row range, the band
+// function is usually a small adapter:
+//
+//     static void convert_band(void* user_data, int y0, int y1) {
+//         frontend_t* fe = user_data;
+//         fbconv_convert_band(&fe->conv, fe->sys.fb, fe->pixels, NULL, NULL, y0, y1);
+//     }
+//     ...
+//     bandpool_run(&pool, ORIC_SCREEN_HEIGHT, convert_band, &fe);
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BANDPOOL_MAX_THREADS      (16)
+#define BANDPOOL_BANDS_PER_THREAD (4)  // Smaller bands even out rows that cost more than others
+
+// Renders rows y0 up to y1 (exclusive)
+typedef void (*bandpool_func_t)(void* user_data, int y0, int y1);
+
+// Frame parameters, each thread copies them under the mutex together with the frame's generation
+typedef struct {
+    bandpool_func_t func;
+    void* user_data;
+    int height;
+    int band_rows;
+    int num_bands;
+} bandpool_frame_t;
+
+// Pool setup
+typedef struct {
+    int num_threads;  // Threads rendering bands including the caller, 1..16 (default 1)
+} bandpool_desc_t;
+
+// Pool state
+typedef struct {
+    int num_threads;
+    pthread_t threads[BANDPOOL_MAX_THREADS];
+    pthread_mutex_t mutex;
+    pthread_cond_t start;  // Signaled when a frame is ready or the pool stops
+    pthread_cond_t done;   // Signaled when the last band of a frame is finished
+    bool running;
+    uint32_t generation;  // Bumped for each frame
+    int active;           // Workers still working on the current frame
+
+    bandpool_frame_t frame;   // Current frame, written under the mutex before generation is bumped
+    atomic_ullong next_band;  // Generation in the high 32 bits, next band of that frame in the low 32 bits
+    int bands_done;
+} bandpool_t;
+
+// Start the worker threads, return false if a thread couldn't be created
+bool bandpool_start(bandpool_t* pool, const bandpool_desc_t* desc);
+
+// Run func over all bands of a frame with height rows, returns when every band is finished
+void bandpool_run(bandpool_t* pool, int height, bandpool_func_t func, void* user_data);
+
+// Stop and join the worker threads
+void bandpool_stop(bandpool_t* pool);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+// Take bands of the frame copied with generation until none are left, called with the mutex unlocked.
+// A worker waking up late finds the bands tagged with a newer generation and leaves them alone.
+static void _bandpool_work(bandpool_t* pool, const bandpool_frame_t* frame, uint32_t generation) {
+    int done = 0;
+    unsigned long long ticket = atomic_load_explicit(&pool->next_band, memory_order_relaxed);
+    while (((uint32_t)(ticket >> 32) == generation) && ((int)(uint32_t)ticket < frame->num_bands)) {
+        if (!atomic_compare_exchange_weak_explicit(&pool->next_band, &ticket, ticket + 1, memory_order_relaxed,
+                                                   memory_order_relaxed)) {
+            continue;
+        }
+        int y0 = (int)(uint32_t)ticket * frame->band_rows;
+        int y1 = (y0 + frame->band_rows < frame->height) ? (y0 + frame->band_rows) : frame->height;
+        frame->func(frame->user_data, y0, y1);
+        done++;
+        ticket++;
+    }
+    if (done > 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->bands_done += done;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void* _bandpool_thread(void* arg) {
+    bandpool_t* pool = (bandpool_t*)arg;
+    uint32_t generation = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->running && (pool->generation == generation)) {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+        if (!pool->running) {
+            break;
+        }
+        generation = pool->generation;
+        bandpool_frame_t frame = pool->frame;
+        pool->active++;
+        pthread_mutex_unlock(&pool->mutex);
+
+        _bandpool_work(pool, &frame, generation);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->active == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+bool bandpool_start(bandpool_t* pool, const bandpool_desc_t* desc) {
+    CHIPS_ASSERT(pool && desc);
+    CHIPS_ASSERT((desc->num_threads >= 0) && (desc->num_threads <= BANDPOOL_MAX_THREADS));
+    memset(pool, 0, sizeof(bandpool_t));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->running = true;
+
+    // The caller renders bands as well
+    int num_threads = CHIPS_DEFAULT(desc->num_threads, 1);
+    for (pool->num_threads = 1; pool->num_threads < num_threads; pool->num_threads++) {
+        if (pthread_create(&pool->threads[pool->num_threads], NULL, _bandpool_thread, pool) != 0) {
+            bandpool_stop(pool);
+            return false;
+        }
+    }
+    return true;
+}
+
+void bandpool_run(bandpool_t* pool, int height, bandpool_func_t func, void* user_data) {
+    CHIPS_ASSERT(pool && pool->running && func && (height > 0));
+    int bands = pool->num_threads * BANDPOOL_BANDS_PER_THREAD;
+    int band_rows = (height + bands - 1) / bands;
+    const bandpool_frame_t frame = {
+        .func = func,
+        .user_data = user_data,
+        .height = height,
+        .band_rows = band_rows,
+        .num_bands = (height + band_rows - 1) / band_rows,
+    };
+    pthread_mutex_lock(&pool->mutex);
+    pool->frame = frame;
+    pool->bands_done = 0;
+    pool->generation++;
+    atomic_store_explicit(&pool->next_band, (unsigned long long)pool->generation << 32, memory_order_relaxed);
+    uint32_t generation = pool->generation;
+    if (pool->num_threads > 1) {
+        pthread_cond_broadcast(&pool->start);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    _bandpool_work(pool, &frame, generation);
+
+    // Wait for the last band and for every worker to leave the frame
+    pthread_mutex_lock(&pool->mutex);
+    while ((pool->bands_done < frame.num_bands) || (pool->active > 0)) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void bandpool_stop(bandpool_t* pool) {
+    CHIPS_ASSERT(pool);
+    pthread_mutex_lock(&pool->mutex);
+    bool running = pool->running;
+    pool->running = false;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    if (running) {
+        for (int i = 1; i < pool->num_threads; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+#endif /* CHIPS_IMPL */
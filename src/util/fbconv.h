@@ -0,0 +1,271 @@
+#pragma once
+
+// Framebuffer conversion for host frontends
+//
+// Converts the packed 4 bits per pixel framebuffer of the emulated systems
+// (two pixels per byte, high nibble first) into packed ARGB8888, RGB565 or
+// 8-bit palette indices, with integer scaling and optional scanline dimming.
+//
+// Every source byte is expanded through a table holding its two pixels
+// already scaled horizontally, the first output line of a source row is
+// then replicated vertically. Only rows flagged in the system's
+// fb_dirty_rows mask need to be converted. The table copies have fixed
+// sizes, so the compiler emits them as a few (vector) moves. On SSE2
+// hosts INDEX8 at scale 1, 2 or 4 skips the table and splits 16 source
+// bytes at a time. tests/fbconv_bench.c measures each format.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FBCONV_MAX_SCALE    (4)
+#define FBCONV_MAX_COLORS   (16)
+#define FBCONV_MAX_EXPANDED (2 * FBCONV_MAX_SCALE * 4)  // Output bytes for one source byte
+
+// Output pixel formats
+typedef enum {
+    FBCONV_FORMAT_ARGB8888,  // Palette entries (0xAARRGGBB) as host-endian 32-bit words, B,G,R,A bytes on x86
+    FBCONV_FORMAT_RGB565,    // Palette entries (0xAARRGGBB) reduced to 16 bits
+    FBCONV_FORMAT_INDEX8,    // Color index, dimmed lines use index + 16
+} fbconv_format_t;
+
+// Conversion setup
+typedef struct {
+    int width;                   // Source width in pixels, must be even
+    int height;                  // Source height in pixels
+    fbconv_format_t format;      // Output pixel format
+    int scale;                   // Integer scale factor 1..4 (default 1)
+    bool scanlines;              // Dim the last output line of each source row (scale >= 2)
+    uint8_t scanline_level;      // Brightness of dimmed lines in 1/256 (default 128)
+    const uint32_t* palette;     // 0xAARRGGBB colors
+    int num_colors;              // Number of palette entries, up to 16
+} fbconv_desc_t;
+
+// Conversion state
+typedef struct {
+    int width;
+    int height;
+    fbconv_format_t format;
+    int scale;
+    int expanded;  // Output bytes for one source byte
+    int pitch;     // Output bytes per line
+    bool scanlines;
+    uint8_t lut[2][256][FBCONV_MAX_EXPANDED];  // [dimmed][source byte]
+} fbconv_t;
+
+// Initialize the conversion tables
+void fbconv_init(fbconv_t* conv, const fbconv_desc_t* desc);
+
+// Return the number of bytes per output line
+int fbconv_pitch(const fbconv_t* conv);
+
+// Return the size in bytes of the output buffer
+size_t fbconv_size(const fbconv_t* conv);
+
+// Convert source row y into its scaled output lines
+void fbconv_convert_row(const fbconv_t* conv, const uint8_t* src, void* dst, int y);
+
+// Convert the rows set in dirty_rows (all rows if NULL), lines maps scanlines to src rows (identity if NULL),
+// return the number of converted rows
+int fbconv_convert(const fbconv_t* conv, const uint8_t* src, void* dst, const uint32_t* dirty_rows,
+                   const uint8_t* lines);
+
+// Same as fbconv_convert() for rows y0 up to y1 (exclusive), bands can be converted in parallel
+int fbconv_convert_band(const fbconv_t* conv, const uint8_t* src, void* dst, const uint32_t* dirty_rows,
+                        const uint8_t* lines, int y0, int y1);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static uint32_t _fbconv_dim(uint32_t color, uint8_t level) {
+    uint32_t r = (((color >> 16) & 0xFF) * level) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * level) >> 8;
+    uint32_t b = ((color & 0xFF) * level) >> 8;
+    return (color & 0xFF000000) | (r << 16) | (g << 8) | b;
+}
+
+static int _fbconv_put_pixel(uint8_t* dst, fbconv_format_t format, const fbconv_desc_t* desc, int index,
+                             bool dimmed) {
+    uint32_t color = (index < desc->num_colors) ? desc->palette[index] : 0xFF000000;
+    if (dimmed) {
+        color = _fbconv_dim(color, desc->scanline_level);
+    }
+    switch (format) {
+        case FBCONV_FORMAT_ARGB8888:
+            memcpy(dst, &color, 4);
+            return 4;
+        case FBCONV_FORMAT_RGB565: {
+            uint16_t c = (uint16_t)((((color >> 19) & 0x1F) << 11) | (((color >> 10) & 0x3F) << 5) | ((color >> 3) & 0x1F));
+            memcpy(dst, &c, 2);
+            return 2;
+        }
+        default:
+            dst[0] = (uint8_t)(dimmed ? (index + FBCONV_MAX_COLORS) : index);
+            return 1;
+    }
+}
+
+void fbconv_init(fbconv_t* conv, const fbconv_desc_t* desc) {
+    CHIPS_ASSERT(conv && desc);
+    CHIPS_ASSERT(desc->width > 0 && (desc->width & 1) == 0 && desc->height > 0);
+    CHIPS_ASSERT(desc->palette && desc->num_colors <= FBCONV_MAX_COLORS);
+    fbconv_desc_t d = *desc;
+    d.scale = CHIPS_DEFAULT(d.scale, 1);
+    d.scanline_level = CHIPS_DEFAULT(d.scanline_level, 128);
+    CHIPS_ASSERT(d.scale <= FBCONV_MAX_SCALE);
+
+    memset(conv, 0, sizeof(fbconv_t));
+    conv->width = d.width;
+    conv->height = d.height;
+    conv->format = d.format;
+    conv->scale = d.scale;
+    conv->scanlines = d.scanlines && (d.scale > 1);
+
+    int bytes_per_pixel = (d.format == FBCONV_FORMAT_ARGB8888) ? 4 : (d.format == FBCONV_FORMAT_RGB565) ? 2 : 1;
+    conv->expanded = 2 * d.scale * bytes_per_pixel;
+    conv->pitch = d.width * d.scale * bytes_per_pixel;
+
+    for (int dimmed = 0; dimmed < 2; dimmed++) {
+        for (int byte = 0; byte < 256; byte++) {
+            uint8_t* dst = conv->lut[dimmed][byte];
+            for (int i = 0; i < d.scale; i++) {
+                dst += _fbconv_put_pixel(dst, d.format, &d, byte >> 4, dimmed);
+            }
+            for (int i = 0; i < d.scale; i++) {
+                dst += _fbconv_put_pixel(dst, d.format, &d, byte & 0xF, dimmed);
+            }
+        }
+    }
+}
+
+int fbconv_pitch(const fbconv_t* conv) {
+    CHIPS_ASSERT(conv);
+    return conv->pitch;
+}
+
+size_t fbconv_size(const fbconv_t* conv) {
+    CHIPS_ASSERT(conv);
+    return (size_t)conv->pitch * conv->height * conv->scale;
+}
+
+// Fixed size copies let the compiler turn each table lookup into a few moves
+#define _FBCONV_EXPAND(size)                        \
+    for (; i < n; i++, dst += (size)) {             \
+        memcpy(dst, lut[src[i]], (size));           \
+    }
+
+#if defined(__SSE2__)
+// INDEX8 at scale 1, 2 or 4 needs no table, the nibbles of 16 source bytes are split and interleaved at once,
+// each doubling repeats every pixel. Returns the number of source bytes done, the table converts the rest.
+static int _fbconv_expand_index8(const fbconv_t* conv, const uint8_t* src, uint8_t* dst, int dimmed) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i offset = _mm_set1_epi8(dimmed ? FBCONV_MAX_COLORS : 0);
+    const int n = conv->width / 2;
+    const int scale = conv->scale;
+    int i = 0;
+    for (; i + 16 <= n; i += 16, dst += 32 * scale) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i hi = _mm_add_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), mask), offset);
+        const __m128i lo = _mm_add_epi8(_mm_and_si128(v, mask), offset);
+        const __m128i p0 = _mm_unpacklo_epi8(hi, lo);
+        const __m128i p1 = _mm_unpackhi_epi8(hi, lo);
+        if (scale == 1) {
+            _mm_storeu_si128((__m128i*)dst, p0);
+            _mm_storeu_si128((__m128i*)(dst + 16), p1);
+            continue;
+        }
+        const __m128i d[4] = {_mm_unpacklo_epi8(p0, p0), _mm_unpackhi_epi8(p0, p0), _mm_unpacklo_epi8(p1, p1),
+                              _mm_unpackhi_epi8(p1, p1)};
+        for (int k = 0; k < 4; k++) {
+            if (scale == 2) {
+                _mm_storeu_si128((__m128i*)(dst + 16 * k), d[k]);
+            } else {
+                _mm_storeu_si128((__m128i*)(dst + 32 * k), _mm_unpacklo_epi8(d[k], d[k]));
+                _mm_storeu_si128((__m128i*)(dst + 32 * k + 16), _mm_unpackhi_epi8(d[k], d[k]));
+            }
+        }
+    }
+    return i;
+}
+#endif
+
+static void _fbconv_expand_line(const fbconv_t* conv, const uint8_t* src, uint8_t* dst, int dimmed) {
+    const uint8_t(*lut)[FBCONV_MAX_EXPANDED] = conv->lut[dimmed];
+    const int n = conv->width / 2;
+    int i = 0;
+#if defined(__SSE2__)
+    if ((conv->format == FBCONV_FORMAT_INDEX8) && (conv->scale != 3)) {
+        i = _fbconv_expand_index8(conv, src, dst, dimmed);
+        dst += i * conv->expanded;
+    }
+#endif
+    switch (conv->expanded) {
+        case 2: _FBCONV_EXPAND(2); break;
+        case 4: _FBCONV_EXPAND(4); break;
+        case 6: _FBCONV_EXPAND(6); break;
+        case 8: _FBCONV_EXPAND(8); break;
+        case 12: _FBCONV_EXPAND(12); break;
+        case 16: _FBCONV_EXPAND(16); break;
+        case 24: _FBCONV_EXPAND(24); break;
+        case 32: _FBCONV_EXPAND(32); break;
+        default: _FBCONV_EXPAND(conv->expanded); break;
+    }
+}
+
+static void _fbconv_convert_row(const fbconv_t* conv, const uint8_t* src_row, void* dst, int y) {
+    uint8_t* first = (uint8_t*)dst + (size_t)y * conv->scale * conv->pitch;
+    _fbconv_expand_line(conv, src_row, first, 0);
+    uint8_t* line = first + conv->pitch;
+    for (int i = 1; i < conv->scale; i++, line += conv->pitch) {
+        if (conv->scanlines && (i == conv->scale - 1)) {
+            _fbconv_expand_line(conv, src_row, line, 1);
+        } else {
+            memcpy(line, first, conv->pitch);
+        }
+    }
+}
+
+void fbconv_convert_row(const fbconv_t* conv, const uint8_t* src, void* dst, int y) {
+    CHIPS_ASSERT(conv && src && dst && (y >= 0) && (y < conv->height));
+    _fbconv_convert_row(conv, src + y * (conv->width / 2), dst, y);
+}
+
+int fbconv_convert_band(const fbconv_t* conv, const uint8_t* src, void* dst, const uint32_t* dirty_rows,
+                        const uint8_t* lines, int y0, int y1) {
+    CHIPS_ASSERT(conv && src && dst && (y0 >= 0) && (y1 <= conv->height));
+    int rows = 0;
+    for (int y = y0; y < y1; y++) {
+        if (dirty_rows && !chips_fb_dirty_test(dirty_rows, y)) {
+            continue;
+        }
+        _fbconv_convert_row(conv, src + (lines ? lines[y] : y) * (conv->width / 2), dst, y);
+        rows++;
+    }
+    return rows;
+}
+
+int fbconv_convert(const fbconv_t* conv, const uint8_t* src, void* dst, const uint32_t* dirty_rows,
+                   const uint8_t* lines) {
+    CHIPS_ASSERT(conv);
+    return fbconv_convert_band(conv, src, dst, dirty_rows, lines, 0, conv->height);
+}
+
+#endif /* CHIPS_IMPL */
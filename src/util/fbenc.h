@@ -0,0 +1,228 @@
+#pragma once
+
+// Streaming framebuffer encoder
+//
+// Writes a sequence of packed 4bpp framebuffers to a file or pipe, storing
+// only what changed since the previous frame. Only the rows flagged in the
+// system's fb_dirty_rows mask are compared against the last encoded frame,
+// each row that really changed is stored as its changed byte range,
+// PackBits compressed. A static screen costs 3 bytes per frame.
+//
+// Stream layout, all values little endian:
+//
+//     header:  "RFB1", u16 width, u16 height      (pixels)
+//     frame:   'F', u16 num_spans, span[num_spans]
+//     span:    u16 y, u16 x, u16 length, u16 size  (x and length in bytes)
+//              followed by size bytes of PackBits data
+//
+// PackBits: a control byte n in 0..127 is followed by n + 1 literal bytes,
+// n in 129..255 by one byte repeated 257 - n times.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FBENC_MAX_FRAMEBUFFER_SIZE (280 * 192)  // Largest system framebuffer (Apple II)
+#define FBENC_MAX_ROW_BYTES        (280)
+#define FBENC_MAX_ROWS             (224)                  // Tallest system framebuffer (Oric)
+#define FBENC_MAX_PACKED_ROW       (FBENC_MAX_ROW_BYTES + (FBENC_MAX_ROW_BYTES + 127) / 128)
+#define FBENC_MAX_FRAME_SIZE       (3 + FBENC_MAX_ROWS * (8 + FBENC_MAX_PACKED_ROW))
+
+// Encoder setup
+typedef struct {
+    int width;   // Framebuffer width in pixels
+    int height;  // Framebuffer height in pixels
+    FILE* file;  // Output file or pipe
+} fbenc_desc_t;
+
+// Encoder state
+typedef struct {
+    int width;
+    int height;
+    int pitch;  // Bytes per row
+    FILE* file;
+    bool first_frame;
+    uint32_t frames;
+    uint32_t spans;
+    uint64_t bytes;
+    uint8_t prev[FBENC_MAX_FRAMEBUFFER_SIZE];  // Last encoded frame
+    uint8_t frame[FBENC_MAX_FRAME_SIZE];       // Frame being encoded, written in one go
+} fbenc_t;
+
+// Initialize the encoder and write the stream header
+void fbenc_init(fbenc_t* enc, const fbenc_desc_t* desc);
+
+// Encode a frame, comparing the rows set in dirty_rows (all rows if NULL), lines maps scanlines to fb rows
+// (identity if NULL), return the number of bytes written
+size_t fbenc_encode(fbenc_t* enc, const uint8_t* fb, const uint32_t* dirty_rows, const uint8_t* lines);
+
+// PackBits compress size bytes, return the compressed size (at most size + (size + 127) / 128)
+size_t fbenc_pack(const uint8_t* src, size_t size, uint8_t* dst);
+
+// Apply one encoded frame to fb (height rows of pitch bytes), return the number of bytes consumed or 0 on
+// malformed input
+size_t fbenc_decode_frame(const uint8_t* data, size_t size, uint8_t* fb, int pitch, int height);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+static uint8_t* _fbenc_put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint16_t _fbenc_get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static size_t _fbenc_write(fbenc_t* enc, const void* data, size_t size) {
+    fwrite(data, 1, size, enc->file);
+    enc->bytes += size;
+    return size;
+}
+
+void fbenc_init(fbenc_t* enc, const fbenc_desc_t* desc) {
+    CHIPS_ASSERT(enc && desc && desc->file);
+    CHIPS_ASSERT((desc->width > 0) && ((desc->width & 1) == 0) && (desc->width / 2 <= FBENC_MAX_ROW_BYTES));
+    CHIPS_ASSERT((desc->height > 0) && (desc->height <= FBENC_MAX_ROWS));
+    CHIPS_ASSERT((desc->width / 2) * desc->height <= FBENC_MAX_FRAMEBUFFER_SIZE);
+    memset(enc, 0, sizeof(fbenc_t));
+    enc->width = desc->width;
+    enc->height = desc->height;
+    enc->pitch = desc->width / 2;
+    enc->file = desc->file;
+    enc->first_frame = true;
+
+    uint8_t header[8] = {'R', 'F', 'B', '1'};
+    _fbenc_put16(_fbenc_put16(&header[4], (uint16_t)enc->width), (uint16_t)enc->height);
+    _fbenc_write(enc, header, sizeof(header));
+}
+
+size_t fbenc_pack(const uint8_t* src, size_t size, uint8_t* dst) {
+    uint8_t* p = dst;
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while ((i + run < size) && (run < 128) && (src[i + run] == src[i])) {
+            run++;
+        }
+        if (run >= 2) {
+            *p++ = (uint8_t)(257 - run);
+            *p++ = src[i];
+            i += run;
+            continue;
+        }
+        // Literals up to the next run of at least 3 equal bytes
+        size_t start = i++;
+        while ((i < size) && (i - start < 128)) {
+            if ((i + 2 < size) && (src[i] == src[i + 1]) && (src[i] == src[i + 2])) {
+                break;
+            }
+            i++;
+        }
+        *p++ = (uint8_t)(i - start - 1);
+        memcpy(p, &src[start], i - start);
+        p += i - start;
+    }
+    return (size_t)(p - dst);
+}
+
+size_t fbenc_encode(fbenc_t* enc, const uint8_t* fb, const uint32_t* dirty_rows, const uint8_t* lines) {
+    CHIPS_ASSERT(enc && fb);
+    const int pitch = enc->pitch;
+
+    uint8_t* p = &enc->frame[3];
+    uint16_t num_spans = 0;
+    for (int y = 0; y < enc->height; y++) {
+        if (!enc->first_frame && dirty_rows && !chips_fb_dirty_test(dirty_rows, y)) {
+            continue;
+        }
+        const uint8_t* row = &fb[(lines ? lines[y] : y) * pitch];
+        uint8_t* prev = &enc->prev[y * pitch];
+        int x0 = 0, x1 = pitch;
+        if (!enc->first_frame) {
+            while ((x0 < pitch) && (row[x0] == prev[x0])) {
+                x0++;
+            }
+            if (x0 == pitch) {
+                continue;
+            }
+            while (row[x1 - 1] == prev[x1 - 1]) {
+                x1--;
+            }
+        }
+        size_t size = fbenc_pack(&row[x0], (size_t)(x1 - x0), &p[8]);
+        p = _fbenc_put16(p, (uint16_t)y);
+        p = _fbenc_put16(p, (uint16_t)x0);
+        p = _fbenc_put16(p, (uint16_t)(x1 - x0));
+        p = _fbenc_put16(p, (uint16_t)size) + size;
+        memcpy(&prev[x0], &row[x0], (size_t)(x1 - x0));
+        num_spans++;
+    }
+
+    enc->frame[0] = 'F';
+    _fbenc_put16(&enc->frame[1], num_spans);
+    enc->first_frame = false;
+    enc->frames++;
+    enc->spans += num_spans;
+    return _fbenc_write(enc, enc->frame, (size_t)(p - enc->frame));
+}
+
+size_t fbenc_decode_frame(const uint8_t* data, size_t size, uint8_t* fb, int pitch, int height) {
+    CHIPS_ASSERT(data && fb);
+    if ((size < 3) || (data[0] != 'F')) {
+        return 0;
+    }
+    uint16_t num_spans = _fbenc_get16(&data[1]);
+    size_t pos = 3;
+    for (int i = 0; i < num_spans; i++) {
+        if (pos + 8 > size) {
+            return 0;
+        }
+        uint16_t y = _fbenc_get16(&data[pos]);
+        uint16_t x = _fbenc_get16(&data[pos + 2]);
+        uint16_t length = _fbenc_get16(&data[pos + 4]);
+        size_t end = pos + 8 + _fbenc_get16(&data[pos + 6]);
+        if ((end > size) || (y >= height) || (x + length > pitch)) {
+            return 0;
+        }
+        uint8_t* dst = &fb[y * pitch + x];
+        uint8_t* dst_end = dst + length;
+        for (pos += 8; pos < end;) {
+            uint8_t n = data[pos++];
+            if (n < 128) {
+                if ((pos + n + 1 > end) || (dst + n + 1 > dst_end)) {
+                    return 0;
+                }
+                memcpy(dst, &data[pos], n + 1);
+                dst += n + 1;
+                pos += n + 1;
+            } else if (n > 128) {
+                if ((pos >= end) || (dst + 257 - n > dst_end)) {
+                    return 0;
+                }
+                memset(dst, data[pos++], 257 - n);
+                dst += 257 - n;
+            }
+        }
+    }
+    return pos;
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,184 @@
+#pragma once
+
+// NTSC composite decoder for the Apple II dot stream
+//
+// With composite rendering enabled the Apple II systems write one fb pixel
+// per 14 MHz dot, 15 for a lit dot and 0 otherwise. This decoder turns that
+// stream into 0xAARRGGBB colors the way a composite monitor does: luma and
+// chroma are low-pass filtered over a sliding window of dots, chroma at the
+// 4-dot color subcarrier period.
+//
+// The chroma filter gives the share of lit dots at each of the four
+// subcarrier phases, which blends the palette colors of the 4-dot patterns,
+// the sharper luma filter then adds the remaining brightness detail. A
+// solid 4-dot pattern c decodes to exactly palette[c], keeping lores colors
+// and the artifact color renderer in agreement. All of it is precomputed
+// into tables indexed by (subcarrier phase, dot window), leaving a single
+// lookup per output pixel.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NTSC_WINDOW_BITS   (12)  // Dots seen by the filters
+#define NTSC_WINDOW_CENTER (6)   // Window bit of the decoded dot
+#define NTSC_NUM_COLORS    (16)
+
+// Decoder setup
+typedef struct {
+    const uint32_t* palette;  // 16 0xAARRGGBB colors, palette[c] is the color of the 4-dot pattern c
+} ntsc_desc_t;
+
+// Decoder tables
+typedef struct {
+    uint32_t color[4][1 << NTSC_WINDOW_BITS];  // [phase][dot window]
+    uint32_t mono[1 << NTSC_WINDOW_BITS];      // [dot window], color burst off
+} ntsc_t;
+
+// Precompute the decoder tables
+void ntsc_init(ntsc_t* ntsc, const ntsc_desc_t* desc);
+
+// Decode one row of width dots, use color = false for text modes (no color burst)
+void ntsc_decode_row(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, bool color);
+
+// Decode the rows set in dirty_rows (all rows if NULL), lines maps scanlines to src rows (identity if NULL),
+// return the number of decoded rows
+int ntsc_decode(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, int height, bool color,
+                const uint32_t* dirty_rows, const uint8_t* lines);
+
+// Same as ntsc_decode() for rows y0 up to y1 (exclusive), bands can be decoded in parallel
+int ntsc_decode_band(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, bool color,
+                     const uint32_t* dirty_rows, const uint8_t* lines, int y0, int y1);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+// Filter taps over the dot window, each phase of the subcarrier sums to 1/4
+// so that flat patterns come out at exactly their palette color
+static const float _ntsc_luma_taps[NTSC_WINDOW_BITS] = {
+    0, 0, 1 / 16.f, 2 / 16.f, 2 / 16.f, 2 / 16.f, 2 / 16.f, 2 / 16.f, 2 / 16.f, 2 / 16.f, 1 / 16.f, 0,
+};
+static const float _ntsc_chroma_taps[NTSC_WINDOW_BITS] = {
+    1 / 24.f, 1 / 24.f, 2 / 24.f, 2 / 24.f, 3 / 24.f, 3 / 24.f,
+    3 / 24.f, 3 / 24.f, 2 / 24.f, 2 / 24.f, 1 / 24.f, 1 / 24.f,
+};
+// A monitor without color burst keeps the full luma bandwidth
+static const float _ntsc_mono_taps[NTSC_WINDOW_BITS] = {
+    0, 0, 0, 0, 0, 1 / 4.f, 2 / 4.f, 1 / 4.f, 0, 0, 0, 0,
+};
+
+static float _ntsc_channel(uint32_t color, int i) { return (float)((color >> (16 - i * 8)) & 0xFF); }
+
+static uint32_t _ntsc_pack(const float rgb[3]) {
+    uint32_t color = 0xFF000000;
+    for (int i = 0; i < 3; i++) {
+        float v = rgb[i] + 0.5f;
+        uint32_t c = (v <= 0.f) ? 0 : (v >= 255.f) ? 255 : (uint32_t)v;
+        color |= c << (16 - i * 8);
+    }
+    return color;
+}
+
+void ntsc_init(ntsc_t* ntsc, const ntsc_desc_t* desc) {
+    CHIPS_ASSERT(ntsc && desc && desc->palette);
+    memset(ntsc, 0, sizeof(ntsc_t));
+    const uint32_t white = desc->palette[NTSC_NUM_COLORS - 1];
+
+    for (uint32_t w = 0; w < (1 << NTSC_WINDOW_BITS); w++) {
+        float luma = 0.f, mono = 0.f;
+        for (int j = 0; j < NTSC_WINDOW_BITS; j++) {
+            if (w & (1 << j)) {
+                luma += _ntsc_luma_taps[j];
+                mono += _ntsc_mono_taps[j];
+            }
+        }
+
+        for (int phase = 0; phase < 4; phase++) {
+            // Share of lit dots at each subcarrier phase, 0..1
+            float share[4] = {0};
+            for (int j = 0; j < NTSC_WINDOW_BITS; j++) {
+                if (w & (1 << j)) {
+                    share[(phase + j - NTSC_WINDOW_CENTER) & 3] += 4.f * _ntsc_chroma_taps[j];
+                }
+            }
+
+            float rgb[3] = {0};
+            for (int c = 0; c < NTSC_NUM_COLORS; c++) {
+                float weight = 1.f;
+                for (int k = 0; k < 4; k++) {
+                    weight *= (c & (1 << k)) ? share[k] : (1.f - share[k]);
+                }
+                for (int i = 0; i < 3; i++) {
+                    rgb[i] += weight * _ntsc_channel(desc->palette[c], i);
+                }
+            }
+            float detail = luma - (share[0] + share[1] + share[2] + share[3]) / 4.f;
+            for (int i = 0; i < 3; i++) {
+                rgb[i] += detail * _ntsc_channel(white, i);
+            }
+            ntsc->color[phase][w] = _ntsc_pack(rgb);
+        }
+
+        float rgb[3] = {_ntsc_channel(white, 0) * mono, _ntsc_channel(white, 1) * mono, _ntsc_channel(white, 2) * mono};
+        ntsc->mono[w] = _ntsc_pack(rgb);
+    }
+}
+
+static inline uint32_t _ntsc_dot(const uint8_t* src, int x, int width) {
+    if (x >= width) {
+        return 0;
+    }
+    uint8_t pixel = (x & 1) ? (src[x >> 1] & 0x0F) : (src[x >> 1] >> 4);
+    return pixel ? 1 : 0;
+}
+
+void ntsc_decode_row(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, bool color) {
+    CHIPS_ASSERT(ntsc && src && dst && ((width & 1) == 0));
+    const int ahead = NTSC_WINDOW_BITS - 1 - NTSC_WINDOW_CENTER;
+
+    // Window bit j holds dot x + j - NTSC_WINDOW_CENTER, dots outside the row are dark
+    uint32_t w = 0;
+    for (int x = 0; x < ahead; x++) {
+        w = (w >> 1) | (_ntsc_dot(src, x, width) << (NTSC_WINDOW_BITS - 1));
+    }
+    for (int x = 0; x < width; x++) {
+        w = (w >> 1) | (_ntsc_dot(src, x + ahead, width) << (NTSC_WINDOW_BITS - 1));
+        dst[x] = color ? ntsc->color[x & 3][w] : ntsc->mono[w];
+    }
+}
+
+int ntsc_decode_band(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, bool color,
+                     const uint32_t* dirty_rows, const uint8_t* lines, int y0, int y1) {
+    CHIPS_ASSERT(ntsc && src && dst && (y0 >= 0) && (y0 <= y1));
+    int rows = 0;
+    for (int y = y0; y < y1; y++) {
+        if (dirty_rows && !chips_fb_dirty_test(dirty_rows, y)) {
+            continue;
+        }
+        ntsc_decode_row(ntsc, src + (lines ? lines[y] : y) * (width / 2), dst + y * width, width, color);
+        rows++;
+    }
+    return rows;
+}
+
+int ntsc_decode(const ntsc_t* ntsc, const uint8_t* src, uint32_t* dst, int width, int height, bool color,
+                const uint32_t* dirty_rows, const uint8_t* lines) {
+    return ntsc_decode_band(ntsc, src, dst, width, color, dirty_rows, lines, 0, height);
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,203 @@
+#pragma once
+
+// Headless video recorder
+//
+// Records emulated frames to a Y4M (4:4:4) or raw RGB24 stream at the full
+// emulated frame rate, for host builds only (pthreads and C11 atomics).
+//
+// The emulation thread hands the packed 4bpp framebuffer to
+// recorder_submit(), which copies it into a free slot of a lock-free single
+// producer / single consumer queue (util/ringwriter.h) and returns
+// immediately. A writer thread expands the frames through the palette and
+// does all file I/O. When the writer falls behind and the queue is full the
+// frame is dropped and counted, the emulation never blocks on disk.
+//
+// Typical use, the frame rate is the emulated one (50 Hz for the Oric, 60 Hz
+// for the Apple II):
+//
+//     recorder_start(&rec, &(recorder_desc_t){
+//         .width = ORIC_SCREEN_WIDTH, .height = ORIC_SCREEN_HEIGHT,
+//         .frame_rate_num = 50, .format = RECORDER_FORMAT_Y4M,
+//         .palette = palette, .num_colors = 8, .file = file});
+//     ...
+//     oric_exec(&sys, 20000);
+//     oric_screen_update(&sys);
+//     recorder_submit(&rec, sys.fb, NULL);
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h and util/ringwriter.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define RECORDER_QUEUE_SLOTS          (16)         // Power of 2
+#define RECORDER_MAX_FRAMEBUFFER_SIZE (280 * 192)  // Largest system framebuffer (Apple II)
+#define RECORDER_MAX_WIDTH            (560)
+
+// Output stream formats
+typedef enum {
+    RECORDER_FORMAT_Y4M,  // YUV4MPEG2, 4:4:4 planes
+    RECORDER_FORMAT_RGB,  // Raw RGB24 frames
+} recorder_format_t;
+
+// Recorder setup
+typedef struct {
+    int width;                 // Framebuffer width in pixels
+    int height;                // Framebuffer height in pixels
+    int frame_rate_num;        // Frame rate numerator, required
+    int frame_rate_den;        // Frame rate denominator (default 1)
+    recorder_format_t format;  // Output format
+    const uint32_t* palette;   // 0xAARRGGBB colors
+    int num_colors;            // Number of palette entries, up to 16
+    FILE* file;                // Output file or pipe
+} recorder_desc_t;
+
+// Recorder state
+typedef struct {
+    int width;
+    int height;
+    int pitch;  // Bytes per framebuffer row
+    recorder_format_t format;
+    FILE* file;
+    uint8_t colors[16][3];  // Palette as RGB or YUV
+
+    ringwriter_t writer;  // Counts slots
+
+    atomic_uint frames_submitted;
+    atomic_uint frames_dropped;
+    atomic_uint frames_written;
+
+    uint8_t slots[RECORDER_QUEUE_SLOTS][RECORDER_MAX_FRAMEBUFFER_SIZE];
+    uint8_t line[RECORDER_MAX_WIDTH * 3];  // Writer thread scratch
+} recorder_t;
+
+// Write the stream header and start the writer thread, return false if the thread couldn't be created
+bool recorder_start(recorder_t* rec, const recorder_desc_t* desc);
+
+// Queue a frame from the emulation thread, lines maps scanlines to fb rows (identity if NULL), return false if it
+// was dropped
+bool recorder_submit(recorder_t* rec, const uint8_t* fb, const uint8_t* lines);
+
+// Write the queued frames and stop the writer thread
+void recorder_stop(recorder_t* rec);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+static uint8_t _recorder_clamp(int v) { return (uint8_t)((v < 0) ? 0 : (v > 255) ? 255 : v); }
+
+// BT.601 studio range
+static void _recorder_rgb_to_yuv(uint32_t color, uint8_t yuv[3]) {
+    int r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, b = color & 0xFF;
+    yuv[0] = _recorder_clamp(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    yuv[1] = _recorder_clamp(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    yuv[2] = _recorder_clamp(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+static void _recorder_write_frame(recorder_t* rec, const uint8_t* fb) {
+    if (rec->format == RECORDER_FORMAT_Y4M) {
+        fputs("FRAME\n", rec->file);
+        for (int plane = 0; plane < 3; plane++) {
+            for (int y = 0; y < rec->height; y++) {
+                const uint8_t* src = &fb[y * rec->pitch];
+                for (int x = 0; x < rec->pitch; x++) {
+                    rec->line[x * 2] = rec->colors[src[x] >> 4][plane];
+                    rec->line[x * 2 + 1] = rec->colors[src[x] & 0x0F][plane];
+                }
+                fwrite(rec->line, 1, rec->width, rec->file);
+            }
+        }
+    } else {
+        for (int y = 0; y < rec->height; y++) {
+            const uint8_t* src = &fb[y * rec->pitch];
+            uint8_t* dst = rec->line;
+            for (int x = 0; x < rec->pitch; x++) {
+                memcpy(dst, rec->colors[src[x] >> 4], 3);
+                memcpy(dst + 3, rec->colors[src[x] & 0x0F], 3);
+                dst += 6;
+            }
+            fwrite(rec->line, 1, rec->width * 3, rec->file);
+        }
+    }
+}
+
+// Writer thread side, one frame at a time
+static unsigned _recorder_write(void* user_data, unsigned first, unsigned count) {
+    (void)count;
+    recorder_t* rec = (recorder_t*)user_data;
+    _recorder_write_frame(rec, rec->slots[first % RECORDER_QUEUE_SLOTS]);
+    atomic_fetch_add_explicit(&rec->frames_written, 1, memory_order_relaxed);
+    return 1;
+}
+
+bool recorder_start(recorder_t* rec, const recorder_desc_t* desc) {
+    CHIPS_ASSERT(rec && desc && desc->file && desc->palette && (desc->num_colors <= 16));
+    CHIPS_ASSERT((desc->width > 0) && ((desc->width & 1) == 0) && (desc->width <= RECORDER_MAX_WIDTH));
+    CHIPS_ASSERT((desc->height > 0) && ((desc->width / 2) * desc->height <= RECORDER_MAX_FRAMEBUFFER_SIZE));
+    CHIPS_ASSERT(desc->frame_rate_num > 0);
+    memset(rec, 0, sizeof(recorder_t));
+    rec->width = desc->width;
+    rec->height = desc->height;
+    rec->pitch = desc->width / 2;
+    rec->format = desc->format;
+    rec->file = desc->file;
+
+    for (int i = 0; i < desc->num_colors; i++) {
+        uint32_t c = desc->palette[i];
+        if (rec->format == RECORDER_FORMAT_Y4M) {
+            _recorder_rgb_to_yuv(c, rec->colors[i]);
+        } else {
+            rec->colors[i][0] = (c >> 16) & 0xFF;
+            rec->colors[i][1] = (c >> 8) & 0xFF;
+            rec->colors[i][2] = c & 0xFF;
+        }
+    }
+
+    if (rec->format == RECORDER_FORMAT_Y4M) {
+        fprintf(rec->file, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C444\n", rec->width, rec->height,
+                desc->frame_rate_num, CHIPS_DEFAULT(desc->frame_rate_den, 1));
+    }
+
+    return ringwriter_start(&rec->writer, &(ringwriter_desc_t){.capacity = RECORDER_QUEUE_SLOTS,
+                                                               .func = _recorder_write,
+                                                               .user_data = rec});
+}
+
+bool recorder_submit(recorder_t* rec, const uint8_t* fb, const uint8_t* lines) {
+    CHIPS_ASSERT(rec && fb);
+    atomic_fetch_add_explicit(&rec->frames_submitted, 1, memory_order_relaxed);
+    unsigned head;
+    if (ringwriter_reserve(&rec->writer, &head) == 0) {
+        atomic_fetch_add_explicit(&rec->frames_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    uint8_t* slot = rec->slots[head % RECORDER_QUEUE_SLOTS];
+    if (lines) {
+        for (int y = 0; y < rec->height; y++) {
+            memcpy(&slot[y * rec->pitch], &fb[lines[y] * rec->pitch], rec->pitch);
+        }
+    } else {
+        memcpy(slot, fb, (size_t)rec->pitch * rec->height);
+    }
+    ringwriter_commit(&rec->writer, 1);
+    return true;
+}
+
+void recorder_stop(recorder_t* rec) {
+    CHIPS_ASSERT(rec);
+    if (ringwriter_stop(&rec->writer)) {
+        fflush(rec->file);
+    }
+}
+
+#endif /* CHIPS_IMPL */
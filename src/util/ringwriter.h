@@ -0,0 +1,131 @@
+#pragma once
+
+// Background writer behind a single producer / single consumer ring
+//
+// Shared by the host capture sinks (util/recorder.h, util/wavcapture.h),
+// for host builds only (pthreads and C11 atomics). The ring only counts
+// items, the owner keeps the storage: the emulation thread asks for free
+// items with ringwriter_reserve(), fills them and publishes them with
+// ringwriter_commit(). A writer thread hands the published items to the
+// write function, which does all file I/O. Nothing blocks the producer,
+// when the ring is full the owner drops the data.
+//
+// Item i lives at index i % capacity of the owner's storage. Counters wrap
+// around, so the capacity must be a power of 2.
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Write out up to count items starting at item first, return the number written (at least 1)
+typedef unsigned (*ringwriter_func_t)(void* user_data, unsigned first, unsigned count);
+
+// Writer setup
+typedef struct {
+    unsigned capacity;       // Number of items in the ring, power of 2
+    ringwriter_func_t func;  // Called from the writer thread
+    void* user_data;
+} ringwriter_desc_t;
+
+// Writer state
+typedef struct {
+    unsigned capacity;
+    ringwriter_func_t func;
+    void* user_data;
+
+    pthread_t thread;
+    atomic_bool running;
+    atomic_uint head;  // Next item to fill, owned by the producer
+    atomic_uint tail;  // Next item to write, owned by the writer thread
+} ringwriter_t;
+
+// Start the writer thread, return false if it couldn't be created
+bool ringwriter_start(ringwriter_t* rw, const ringwriter_desc_t* desc);
+
+// Return the number of free items from the producer, *first receives the index of the first one
+unsigned ringwriter_reserve(ringwriter_t* rw, unsigned* first);
+
+// Publish count items filled after ringwriter_reserve()
+void ringwriter_commit(ringwriter_t* rw, unsigned count);
+
+// Write the published items and stop the writer thread, return false if it wasn't running
+bool ringwriter_stop(ringwriter_t* rw);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memset
+#include <time.h>    // nanosleep
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+static void* _ringwriter_thread(void* arg) {
+    ringwriter_t* rw = (ringwriter_t*)arg;
+    for (;;) {
+        unsigned tail = atomic_load_explicit(&rw->tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&rw->head, memory_order_acquire);
+        if (tail == head) {
+            if (!atomic_load_explicit(&rw->running, memory_order_acquire)) {
+                // Items committed before stop were published before running was cleared
+                if (tail == atomic_load_explicit(&rw->head, memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            nanosleep(&(struct timespec){0, 1000000}, NULL);
+            continue;
+        }
+        unsigned written = rw->func(rw->user_data, tail, head - tail);
+        CHIPS_ASSERT((written > 0) && (written <= head - tail));
+        atomic_store_explicit(&rw->tail, tail + written, memory_order_release);
+    }
+    return NULL;
+}
+
+bool ringwriter_start(ringwriter_t* rw, const ringwriter_desc_t* desc) {
+    CHIPS_ASSERT(rw && desc && desc->func);
+    CHIPS_ASSERT((desc->capacity > 0) && ((desc->capacity & (desc->capacity - 1)) == 0));
+    memset(rw, 0, sizeof(ringwriter_t));
+    rw->capacity = desc->capacity;
+    rw->func = desc->func;
+    rw->user_data = desc->user_data;
+
+    atomic_store(&rw->running, true);
+    if (pthread_create(&rw->thread, NULL, _ringwriter_thread, rw) != 0) {
+        atomic_store(&rw->running, false);
+        return false;
+    }
+    return true;
+}
+
+unsigned ringwriter_reserve(ringwriter_t* rw, unsigned* first) {
+    CHIPS_ASSERT(rw && first);
+    unsigned head = atomic_load_explicit(&rw->head, memory_order_relaxed);
+    *first = head;
+    return rw->capacity - (head - atomic_load_explicit(&rw->tail, memory_order_acquire));
+}
+
+void ringwriter_commit(ringwriter_t* rw, unsigned count) {
+    CHIPS_ASSERT(rw);
+    unsigned head = atomic_load_explicit(&rw->head, memory_order_relaxed);
+    atomic_store_explicit(&rw->head, head + count, memory_order_release);
+}
+
+bool ringwriter_stop(ringwriter_t* rw) {
+    CHIPS_ASSERT(rw);
+    if (!atomic_exchange(&rw->running, false)) {
+        return false;
+    }
+    pthread_join(rw->thread, NULL);
+    return true;
+}
+
+#endif /* CHIPS_IMPL */
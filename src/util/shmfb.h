@@ -0,0 +1,214 @@
+#pragma once
+
+// Shared memory framebuffer export
+//
+// Places the published framebuffer, its palette, a frame counter and the
+// dirty row information in a POSIX shared memory segment (host builds
+// only). External viewers map the segment read-only and read frames in
+// place, no per-frame IPC or copies.
+//
+// The writer only copies the rows flagged in the system's fb_dirty_rows
+// mask into the segment. Each published frame stores its dirty rows in
+// dirty_rows, and row_frame[y] records the frame that last changed row y,
+// so readers that skipped frames can still refresh only what changed.
+//
+// Frames are guarded by a sequence lock: sequence is odd while the writer
+// updates the segment. Readers call shmfb_read_begin(), copy out what they
+// need and retry if shmfb_read_retry() returns true.
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdatomic.h>
+
+#define SHMFB_MAGIC                (0x53424652)  // "RFBS"
+#define SHMFB_VERSION              (1)
+#define SHMFB_MAX_ROWS             (224)
+#define SHMFB_MAX_FRAMEBUFFER_SIZE (280 * 224)
+#define SHMFB_MAX_NAME             (64)
+
+// Shared memory segment layout
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;                                             // Framebuffer width in pixels (packed 4bpp)
+    uint32_t height;                                            // Framebuffer height in pixels
+    uint32_t pitch;                                             // Bytes per row
+    uint32_t num_colors;                                        // Number of palette entries
+    uint32_t palette[16];                                       // 0xAARRGGBB colors
+    atomic_uint sequence;                                       // Odd while the writer updates the frame
+    uint32_t frame;                                             // Number of published frames
+    uint32_t dirty_rows[CHIPS_FB_DIRTY_WORDS(SHMFB_MAX_ROWS)];  // Rows changed by the last frame
+    uint32_t row_frame[SHMFB_MAX_ROWS];                         // Frame that last changed each row
+    uint8_t fb[SHMFB_MAX_FRAMEBUFFER_SIZE];
+} shmfb_frame_t;
+
+// Export setup
+typedef struct {
+    const char* name;         // Segment name, e.g. "/reload-oric-0"
+    int width;                // Framebuffer width in pixels
+    int height;               // Framebuffer height in pixels
+    const uint32_t* palette;  // 0xAARRGGBB colors
+    int num_colors;           // Number of palette entries, up to 16
+} shmfb_desc_t;
+
+// Writer state
+typedef struct {
+    char name[SHMFB_MAX_NAME];
+    int fd;
+    shmfb_frame_t* frame;
+} shmfb_t;
+
+// Create the shared memory segment, return false on failure
+bool shmfb_open(shmfb_t* shm, const shmfb_desc_t* desc);
+
+// Publish a frame, dirty_rows are the rows rewritten since the last publish (all rows if NULL), lines maps
+// scanlines to fb rows (identity if NULL), the segment always holds one row per scanline
+void shmfb_publish(shmfb_t* shm, const uint8_t* fb, const uint32_t* dirty_rows, const uint8_t* lines);
+
+// Unmap and remove the shared memory segment
+void shmfb_close(shmfb_t* shm);
+
+// Map an exported segment read-only, return NULL on failure
+const shmfb_frame_t* shmfb_attach(const char* name);
+
+// Unmap a segment mapped with shmfb_attach()
+void shmfb_detach(const shmfb_frame_t* frame);
+
+// Start reading a frame, return the sequence to pass to shmfb_read_retry()
+uint32_t shmfb_read_begin(const shmfb_frame_t* frame);
+
+// Return true if the frame changed while it was read
+bool shmfb_read_retry(const shmfb_frame_t* frame, uint32_t sequence);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+bool shmfb_open(shmfb_t* shm, const shmfb_desc_t* desc) {
+    CHIPS_ASSERT(shm && desc && desc->name && (strlen(desc->name) < SHMFB_MAX_NAME));
+    CHIPS_ASSERT(desc->palette && (desc->num_colors <= 16));
+    CHIPS_ASSERT((desc->width > 0) && ((desc->width & 1) == 0) && (desc->height > 0));
+    CHIPS_ASSERT((desc->height <= SHMFB_MAX_ROWS) && ((desc->width / 2) * desc->height <= SHMFB_MAX_FRAMEBUFFER_SIZE));
+    memset(shm, 0, sizeof(shmfb_t));
+    strcpy(shm->name, desc->name);
+
+    shm->fd = shm_open(shm->name, O_CREAT | O_RDWR, 0644);
+    if (shm->fd < 0) {
+        return false;
+    }
+    if (ftruncate(shm->fd, sizeof(shmfb_frame_t)) != 0) {
+        shmfb_close(shm);
+        return false;
+    }
+    void* ptr = mmap(NULL, sizeof(shmfb_frame_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+    if (ptr == MAP_FAILED) {
+        shmfb_close(shm);
+        return false;
+    }
+    shm->frame = (shmfb_frame_t*)ptr;
+
+    shmfb_frame_t* f = shm->frame;
+    memset(f, 0, sizeof(shmfb_frame_t));
+    f->version = SHMFB_VERSION;
+    f->width = (uint32_t)desc->width;
+    f->height = (uint32_t)desc->height;
+    f->pitch = (uint32_t)desc->width / 2;
+    f->num_colors = (uint32_t)desc->num_colors;
+    memcpy(f->palette, desc->palette, desc->num_colors * sizeof(uint32_t));
+    atomic_init(&f->sequence, 0);
+    // Readers check the magic last
+    atomic_thread_fence(memory_order_release);
+    f->magic = SHMFB_MAGIC;
+    return true;
+}
+
+void shmfb_publish(shmfb_t* shm, const uint8_t* fb, const uint32_t* dirty_rows, const uint8_t* lines) {
+    CHIPS_ASSERT(shm && shm->frame && fb);
+    shmfb_frame_t* f = shm->frame;
+    uint32_t sequence = atomic_load_explicit(&f->sequence, memory_order_relaxed);
+    atomic_store_explicit(&f->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    f->frame++;
+    for (uint32_t y = 0; y < f->height; y++) {
+        if (dirty_rows && !chips_fb_dirty_test(dirty_rows, y)) {
+            continue;
+        }
+        memcpy(&f->fb[y * f->pitch], &fb[(lines ? lines[y] : y) * f->pitch], f->pitch);
+        f->row_frame[y] = f->frame;
+    }
+    if (dirty_rows) {
+        memcpy(f->dirty_rows, dirty_rows, CHIPS_FB_DIRTY_WORDS(f->height) * sizeof(uint32_t));
+    } else {
+        memset(f->dirty_rows, 0xFF, sizeof(f->dirty_rows));
+    }
+
+    atomic_store_explicit(&f->sequence, sequence + 2, memory_order_release);
+}
+
+void shmfb_close(shmfb_t* shm) {
+    CHIPS_ASSERT(shm);
+    if (shm->frame) {
+        munmap(shm->frame, sizeof(shmfb_frame_t));
+        shm->frame = NULL;
+    }
+    if (shm->fd >= 0) {
+        close(shm->fd);
+        shm_unlink(shm->name);
+        shm->fd = -1;
+    }
+}
+
+const shmfb_frame_t* shmfb_attach(const char* name) {
+    CHIPS_ASSERT(name);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    void* ptr = mmap(NULL, sizeof(shmfb_frame_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+    const shmfb_frame_t* frame = (const shmfb_frame_t*)ptr;
+    if ((frame->magic != SHMFB_MAGIC) || (frame->version != SHMFB_VERSION)) {
+        munmap(ptr, sizeof(shmfb_frame_t));
+        return NULL;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return frame;
+}
+
+void shmfb_detach(const shmfb_frame_t* frame) {
+    CHIPS_ASSERT(frame);
+    munmap((void*)frame, sizeof(shmfb_frame_t));
+}
+
+uint32_t shmfb_read_begin(const shmfb_frame_t* frame) {
+    CHIPS_ASSERT(frame);
+    uint32_t sequence;
+    while ((sequence = atomic_load_explicit((atomic_uint*)&frame->sequence, memory_order_acquire)) & 1) {
+    }
+    return sequence;
+}
+
+bool shmfb_read_retry(const shmfb_frame_t* frame, uint32_t sequence) {
+    CHIPS_ASSERT(frame);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit((atomic_uint*)&frame->sequence, memory_order_relaxed) != sequence;
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,121 @@
+#pragma once
+
+// ANSI terminal text frontend
+//
+// Shows a chips_text_screen_t, as decoded by the systems' *_text_screen()
+// functions, on an ANSI terminal. Only the cells that changed since the
+// previous update are written: each run of changed cells in a row costs one
+// cursor move plus the characters, with SGR sequences only where the
+// attributes change. Colors 0..7 follow the ANSI order (bit 0 red, bit 1
+// green, bit 2 blue), higher colors are shown as their low 3 bits.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Terminal state
+typedef struct {
+    FILE* file;
+    bool valid;  // prev holds what the terminal shows
+    chips_text_screen_t prev;
+    uint32_t cells_written;
+} textterm_t;
+
+// Initialize the terminal frontend, the first update redraws everything
+void textterm_init(textterm_t* term, FILE* file);
+
+// Force a full redraw on the next update
+void textterm_invalidate(textterm_t* term);
+
+// Write the cells that changed, return the number of cells written
+int textterm_update(textterm_t* term, const chips_text_screen_t* screen);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+void textterm_init(textterm_t* term, FILE* file) {
+    CHIPS_ASSERT(term && file);
+    memset(term, 0, sizeof(textterm_t));
+    term->file = file;
+}
+
+void textterm_invalidate(textterm_t* term) {
+    CHIPS_ASSERT(term);
+    term->valid = false;
+}
+
+static bool _textterm_cell_changed(const textterm_t* term, const chips_text_screen_t* screen, int row, int col) {
+    return !term->valid || (screen->chars[row][col] != term->prev.chars[row][col]) ||
+           (screen->attrs[row][col] != term->prev.attrs[row][col]) ||
+           (screen->colors[row][col] != term->prev.colors[row][col]);
+}
+
+static void _textterm_sgr(FILE* file, uint8_t attrs, uint8_t colors) {
+    fprintf(file, "\x1b[0;%d;%d%s%s%sm", 30 + (colors & 7), 40 + ((colors >> 4) & 7),
+            (attrs & CHIPS_TEXT_INVERSE) ? ";7" : "", (attrs & CHIPS_TEXT_FLASH) ? ";5" : "",
+            (attrs & CHIPS_TEXT_DOUBLE) ? ";1" : "");
+}
+
+int textterm_update(textterm_t* term, const chips_text_screen_t* screen) {
+    CHIPS_ASSERT(term && term->file && screen);
+    CHIPS_ASSERT((screen->columns <= CHIPS_TEXT_MAX_COLUMNS) && (screen->rows <= CHIPS_TEXT_MAX_ROWS));
+    if (term->valid && ((screen->columns != term->prev.columns) || (screen->rows != term->prev.rows))) {
+        term->valid = false;
+    }
+    if (!term->valid) {
+        fputs("\x1b[0m\x1b[2J", term->file);
+    }
+
+    int cells = 0;
+    for (int row = 0; row < screen->rows; row++) {
+        int col = 0;
+        while (col < screen->columns) {
+            if (!_textterm_cell_changed(term, screen, row, col)) {
+                col++;
+                continue;
+            }
+            fprintf(term->file, "\x1b[%d;%dH", row + 1, col + 1);
+            int last_attrs = -1, last_colors = -1;
+            for (; (col < screen->columns) && _textterm_cell_changed(term, screen, row, col); col++) {
+                uint8_t attrs = screen->attrs[row][col];
+                uint8_t colors = screen->colors[row][col];
+                if ((attrs != last_attrs) || (colors != last_colors)) {
+                    _textterm_sgr(term->file, attrs, colors);
+                    last_attrs = attrs;
+                    last_colors = colors;
+                }
+                char c = screen->chars[row][col];
+                fputc(((c >= 0x20) && (c < 0x7F)) ? c : ' ', term->file);
+                cells++;
+            }
+        }
+    }
+    if (cells > 0) {
+        fputs("\x1b[0m", term->file);
+        fflush(term->file);
+    }
+
+    memcpy(&term->prev, screen, sizeof(chips_text_screen_t));
+    term->valid = true;
+    term->cells_written += cells;
+    return cells;
+}
+
+#endif /* CHIPS_IMPL */
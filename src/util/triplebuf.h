@@ -0,0 +1,196 @@
+#pragma once
+
+// Triple-buffered frame handoff
+//
+// Moves complete frames from the thread (or core) that renders the system
+// framebuffer to the one presenting it, without tearing and without the
+// presenter ever waiting. The producer publishes after a screen update, the
+// consumer always gets the newest complete frame.
+//
+// The system keeps rendering incrementally into its own fb. On publish only
+// the rows rewritten since the back buffer was last filled are copied into
+// it (from the fb_dirty_rows masks), then the back buffer is swapped with
+// the ready one. Consuming swaps the ready buffer with the front buffer if a
+// newer frame was published, no data is copied.
+//
+// A system can also render straight into triplebuf_back(), so that only the
+// three buffers exist. triplebuf_publish_back() then swaps first and copies
+// the rows the new back buffer is missing from the frame just published.
+//
+// The swap is a single exchange of the shared index word, done with C11
+// atomics on the host. The RP2040 cores have no atomic read-modify-write,
+// so on the Pico the exchange is guarded by a hardware spinlock, which also
+// keeps it safe to publish from a timer callback.
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include "hardware/sync.h"
+#define TRIPLEBUF_USE_SPINLOCK (1)
+#else
+#include <stdatomic.h>
+#define TRIPLEBUF_USE_SPINLOCK (0)
+#endif
+
+#define TRIPLEBUF_MAX_ROWS (224)
+
+// Triple buffer setup
+typedef struct {
+    int pitch;              // Bytes per framebuffer row
+    int height;             // Number of rows
+    chips_range_t buffers;  // Storage for the three frames, at least 3 * pitch * height bytes
+} triplebuf_desc_t;
+
+// Triple buffer state
+typedef struct {
+    int pitch;
+    int height;
+    uint8_t* buffers[3];
+    uint8_t back;   // Owned by the producer
+    uint8_t front;  // Owned by the consumer
+#if TRIPLEBUF_USE_SPINLOCK
+    spin_lock_t* lock;
+    volatile uint32_t ready;
+#else
+    atomic_uint ready;  // Index of the ready buffer, bit 2 set until it is consumed
+#endif
+    uint32_t frames;  // Number of published frames, written by the producer
+    uint32_t stale[3][CHIPS_FB_DIRTY_WORDS(TRIPLEBUF_MAX_ROWS)];  // Rows each buffer is missing
+} triplebuf_t;
+
+// Initialize the triple buffer
+void triplebuf_init(triplebuf_t* tb, const triplebuf_desc_t* desc);
+
+// Publish the framebuffer from the producer, dirty_rows are the rows rewritten since the last publish
+void triplebuf_publish(triplebuf_t* tb, const uint8_t* fb, const uint32_t* dirty_rows);
+
+// Return the buffer for the producer to render into in place, it holds the last published frame apart from the rows
+// rewritten since, valid until the next triplebuf_publish_back()
+uint8_t* triplebuf_back(triplebuf_t* tb);
+
+// Publish the frame rendered into triplebuf_back(), dirty_rows are the rows rewritten since the last publish
+void triplebuf_publish_back(triplebuf_t* tb, const uint32_t* dirty_rows);
+
+// Return the newest published frame, valid until the next call from the consumer
+const uint8_t* triplebuf_consume(triplebuf_t* tb);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _TRIPLEBUF_FRESH (1 << 2)
+#define _TRIPLEBUF_INDEX (3)
+
+static uint32_t _triplebuf_exchange(triplebuf_t* tb, uint32_t ready) {
+#if TRIPLEBUF_USE_SPINLOCK
+    uint32_t save = spin_lock_blocking(tb->lock);
+    uint32_t prev = tb->ready;
+    tb->ready = ready;
+    spin_unlock(tb->lock, save);
+    return prev;
+#else
+    return atomic_exchange_explicit(&tb->ready, ready, memory_order_acq_rel);
+#endif
+}
+
+static bool _triplebuf_fresh(triplebuf_t* tb) {
+#if TRIPLEBUF_USE_SPINLOCK
+    return (tb->ready & _TRIPLEBUF_FRESH) != 0;
+#else
+    return (atomic_load_explicit(&tb->ready, memory_order_relaxed) & _TRIPLEBUF_FRESH) != 0;
+#endif
+}
+
+void triplebuf_init(triplebuf_t* tb, const triplebuf_desc_t* desc) {
+    CHIPS_ASSERT(tb && desc);
+    CHIPS_ASSERT((desc->pitch > 0) && (desc->height > 0) && (desc->height <= TRIPLEBUF_MAX_ROWS));
+    CHIPS_ASSERT(desc->buffers.ptr && (desc->buffers.size >= 3 * (size_t)desc->pitch * desc->height));
+    memset(tb, 0, sizeof(triplebuf_t));
+    tb->pitch = desc->pitch;
+    tb->height = desc->height;
+    for (int i = 0; i < 3; i++) {
+        tb->buffers[i] = (uint8_t*)desc->buffers.ptr + i * desc->pitch * desc->height;
+        memset(tb->buffers[i], 0, (size_t)desc->pitch * desc->height);
+        memset(tb->stale[i], 0xFF, sizeof(tb->stale[i]));
+    }
+    tb->back = 0;
+    tb->front = 2;
+#if TRIPLEBUF_USE_SPINLOCK
+    tb->lock = spin_lock_instance(spin_lock_claim_unused(true));
+    tb->ready = 1;
+#else
+    atomic_init(&tb->ready, 1);
+#endif
+}
+
+// Flag the rewritten rows as missing from every buffer
+static void _triplebuf_mark_stale(triplebuf_t* tb, const uint32_t* dirty_rows) {
+    const int words = CHIPS_FB_DIRTY_WORDS(tb->height);
+    if (dirty_rows) {
+        for (int i = 0; i < 3; i++) {
+            for (int w = 0; w < words; w++) {
+                tb->stale[i][w] |= dirty_rows[w];
+            }
+        }
+    } else {
+        for (int i = 0; i < 3; i++) {
+            memset(tb->stale[i], 0xFF, sizeof(tb->stale[i]));
+        }
+    }
+}
+
+// Copy the rows the back buffer is missing from fb
+static void _triplebuf_fill_back(triplebuf_t* tb, const uint8_t* fb) {
+    uint8_t* dst = tb->buffers[tb->back];
+    for (int y = 0; y < tb->height; y++) {
+        if (chips_fb_dirty_test(tb->stale[tb->back], y)) {
+            memcpy(&dst[y * tb->pitch], &fb[y * tb->pitch], tb->pitch);
+        }
+    }
+    memset(tb->stale[tb->back], 0, sizeof(tb->stale[tb->back]));
+}
+
+void triplebuf_publish(triplebuf_t* tb, const uint8_t* fb, const uint32_t* dirty_rows) {
+    CHIPS_ASSERT(tb && fb);
+    _triplebuf_mark_stale(tb, dirty_rows);
+    _triplebuf_fill_back(tb, fb);
+    tb->back = _triplebuf_exchange(tb, tb->back | _TRIPLEBUF_FRESH) & _TRIPLEBUF_INDEX;
+    tb->frames++;
+}
+
+uint8_t* triplebuf_back(triplebuf_t* tb) {
+    CHIPS_ASSERT(tb);
+    return tb->buffers[tb->back];
+}
+
+void triplebuf_publish_back(triplebuf_t* tb, const uint32_t* dirty_rows) {
+    CHIPS_ASSERT(tb);
+    _triplebuf_mark_stale(tb, dirty_rows);
+    // The back buffer is the frame itself
+    memset(tb->stale[tb->back], 0, sizeof(tb->stale[tb->back]));
+    const uint8_t* frame = tb->buffers[tb->back];
+    tb->back = _triplebuf_exchange(tb, tb->back | _TRIPLEBUF_FRESH) & _TRIPLEBUF_INDEX;
+    // The consumer only reads the published frame, so it can be copied from after the swap
+    _triplebuf_fill_back(tb, frame);
+    tb->frames++;
+}
+
+const uint8_t* triplebuf_consume(triplebuf_t* tb) {
+    CHIPS_ASSERT(tb);
+    if (_triplebuf_fresh(tb)) {
+        tb->front = _triplebuf_exchange(tb, tb->front) & _TRIPLEBUF_INDEX;
+    }
+    return tb->buffers[tb->front];
+}
+
+#endif /* CHIPS_IMPL */
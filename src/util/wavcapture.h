@@ -0,0 +1,182 @@
+#pragma once
+
+// Streaming WAV capture of emulated audio
+//
+// Writes the 8-bit mono sample blocks the systems pass to their audio
+// callback into a WAV file, for host builds only (pthreads and C11
+// atomics). Meant for regression runs that need the audio as evidence,
+// beeper and PSG output alike.
+//
+// The emulation thread hands each block to wavcapture_submit(), which
+// copies it into a lock-free single producer / single consumer sample ring
+// (util/ringwriter.h) and returns immediately. A writer thread does all file I/O. When the
+// writer falls behind and a block doesn't fit, the block is dropped and
+// counted, the emulation never blocks on disk. Memory use is the fixed
+// ring, however long the capture runs.
+//
+// The RIFF header is written with unknown sizes (0xFFFFFFFF, which most
+// tools read as "until the end of the stream") and patched when the
+// capture stops, if the file is seekable. 8-bit WAV files are unsigned
+// with silence at 128, the same format as the emulated output, so samples
+// are written unchanged. The 4 GB RIFF limit is reached after about 54
+// hours at 22050 Hz, longer captures keep the size fields at their maximum.
+//
+// The capture can be the audio callback itself:
+//
+//     .audio = {
+//         .callback = {.func = wavcapture_callback, .user_data = &cap},
+//         .sample_rate = 22050,
+//     },
+//
+// or be fed from an existing one with wavcapture_submit().
+//
+// C only, the public structs hold C11 atomics.
+//
+// Include chips/chips_common.h and util/ringwriter.h before this file.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define WAVCAPTURE_RING_SIZE   (1 << 17)  // Samples, power of 2, about 6 seconds at 22050 Hz
+#define WAVCAPTURE_HEADER_SIZE (44)
+
+// Capture setup
+typedef struct {
+    int sample_rate;  // Sample rate of the captured blocks (default 22050)
+    FILE* file;       // Output file, seekable for the header to get its final sizes
+} wavcapture_desc_t;
+
+// Capture state
+typedef struct {
+    FILE* file;
+    int sample_rate;
+
+    ringwriter_t writer;  // Counts samples
+
+    atomic_uint blocks_submitted;
+    atomic_uint blocks_dropped;
+    uint64_t samples_written;  // Owned by the writer thread, valid after wavcapture_stop()
+
+    uint8_t ring[WAVCAPTURE_RING_SIZE];
+} wavcapture_t;
+
+// Write the WAV header and start the writer thread, return false if the thread couldn't be created
+bool wavcapture_start(wavcapture_t* cap, const wavcapture_desc_t* desc);
+
+// Queue a block of samples from the emulation thread, return false if it was dropped
+bool wavcapture_submit(wavcapture_t* cap, const uint8_t* samples, int num_samples);
+
+// Audio callback queueing the blocks of a system, user_data is the wavcapture_t
+void wavcapture_callback(const uint8_t* samples, int num_samples, void* user_data);
+
+// Write the queued samples, stop the writer thread and patch the header sizes
+void wavcapture_stop(wavcapture_t* cap);
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>  // memcpy, memset
+#ifndef CHIPS_ASSERT
+#include <assert.h>
+#define CHIPS_ASSERT(c) assert(c)
+#endif
+
+static void _wavcapture_put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Canonical 44-byte header for 8-bit mono PCM
+static void _wavcapture_header(uint8_t* h, int sample_rate, uint32_t riff_size, uint32_t data_size) {
+    memcpy(&h[0], "RIFF", 4);
+    _wavcapture_put32(&h[4], riff_size);
+    memcpy(&h[8], "WAVEfmt ", 8);
+    _wavcapture_put32(&h[16], 16);  // fmt chunk size
+    h[20] = 1;                      // PCM
+    h[21] = 0;
+    h[22] = 1;  // mono
+    h[23] = 0;
+    _wavcapture_put32(&h[24], (uint32_t)sample_rate);
+    _wavcapture_put32(&h[28], (uint32_t)sample_rate);  // bytes per second
+    h[32] = 1;                                         // block align
+    h[33] = 0;
+    h[34] = 8;  // bits per sample
+    h[35] = 0;
+    memcpy(&h[36], "data", 4);
+    _wavcapture_put32(&h[40], data_size);
+}
+
+// Writer thread side, writes up to the end of the ring, the wrapped part goes out on the next call
+static unsigned _wavcapture_write(void* user_data, unsigned first, unsigned count) {
+    wavcapture_t* cap = (wavcapture_t*)user_data;
+    unsigned pos = first % WAVCAPTURE_RING_SIZE;
+    unsigned len = (count < WAVCAPTURE_RING_SIZE - pos) ? count : WAVCAPTURE_RING_SIZE - pos;
+    fwrite(&cap->ring[pos], 1, len, cap->file);
+    cap->samples_written += len;
+    return len;
+}
+
+bool wavcapture_start(wavcapture_t* cap, const wavcapture_desc_t* desc) {
+    CHIPS_ASSERT(cap && desc && desc->file);
+    memset(cap, 0, sizeof(wavcapture_t));
+    cap->file = desc->file;
+    cap->sample_rate = CHIPS_DEFAULT(desc->sample_rate, 22050);
+
+    uint8_t header[WAVCAPTURE_HEADER_SIZE];
+    _wavcapture_header(header, cap->sample_rate, 0xFFFFFFFF, 0xFFFFFFFF);
+    fwrite(header, 1, sizeof(header), cap->file);
+
+    return ringwriter_start(&cap->writer, &(ringwriter_desc_t){.capacity = WAVCAPTURE_RING_SIZE,
+                                                               .func = _wavcapture_write,
+                                                               .user_data = cap});
+}
+
+bool wavcapture_submit(wavcapture_t* cap, const uint8_t* samples, int num_samples) {
+    CHIPS_ASSERT(cap && samples && (num_samples >= 0) && (num_samples <= WAVCAPTURE_RING_SIZE));
+    atomic_fetch_add_explicit(&cap->blocks_submitted, 1, memory_order_relaxed);
+    unsigned head;
+    if ((unsigned)num_samples > ringwriter_reserve(&cap->writer, &head)) {
+        atomic_fetch_add_explicit(&cap->blocks_dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    unsigned pos = head % WAVCAPTURE_RING_SIZE;
+    unsigned first = ((unsigned)num_samples < WAVCAPTURE_RING_SIZE - pos) ? (unsigned)num_samples
+                                                                           : WAVCAPTURE_RING_SIZE - pos;
+    memcpy(&cap->ring[pos], samples, first);
+    memcpy(cap->ring, samples + first, (size_t)num_samples - first);
+    ringwriter_commit(&cap->writer, (unsigned)num_samples);
+    return true;
+}
+
+void wavcapture_callback(const uint8_t* samples, int num_samples, void* user_data) {
+    wavcapture_submit((wavcapture_t*)user_data, samples, num_samples);
+}
+
+void wavcapture_stop(wavcapture_t* cap) {
+    CHIPS_ASSERT(cap);
+    if (!ringwriter_stop(&cap->writer)) {
+        return;
+    }
+    if (cap->samples_written & 1) {
+        // RIFF chunks have an even size, the pad byte isn't part of the data
+        fputc(0, cap->file);
+    }
+    // Patch the sizes, a pipe keeps the streaming header
+    if (fseek(cap->file, 0, SEEK_SET) == 0) {
+        const uint64_t max_data = 0xFFFFFFFE - (WAVCAPTURE_HEADER_SIZE - 8);
+        uint32_t data_size = (uint32_t)((cap->samples_written < max_data) ? cap->samples_written : max_data);
+        uint32_t riff_size = data_size + (WAVCAPTURE_HEADER_SIZE - 8) + (data_size & 1);
+        uint8_t header[WAVCAPTURE_HEADER_SIZE];
+        _wavcapture_header(header, cap->sample_rate, riff_size, data_size);
+        fwrite(header, 1, sizeof(header), cap->file);
+        fseek(cap->file, 0, SEEK_END);
+    }
+    fflush(cap->file);
+}
+
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,137 @@
+// Apple II / IIe on-demand line rendering against the framebuffer path
+//
+// Fills RAM and the character ROM with random data, then for every
+// combination of the video switches renders the screen through the
+// framebuffer (screen_update, read through fb_line[]) and line by line with
+// render_line(), which the Pico builds use for scan-out. Every scanline must
+// match. Built once per system, APPLE2E selects the IIe.
+//
+// The bottom text lines of mixed-mode lores are a known mismatch: the fb
+// path's lores pass clears the shared text page dirty flag before the text
+// pass, so those lines are never refreshed. They are skipped here and only
+// checked with --mixed-lores, registered as an expected failure.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico_host.h"
+#include "chips/chips_common.h"
+#include "chips/wdc65C02cpu.h"
+#include "chips/resampler.h"
+#include "chips/beeper.h"
+#include "chips/mos6522via.h"
+#include "chips/ay38910psg.h"
+#include "chips/kbd.h"
+#include "chips/mem.h"
+#include "chips/clk.h"
+#include "devices/apple2_lc.h"
+#include "devices/disk2_nib.h"
+#include "devices/disk2_fdd.h"
+#include "devices/disk2_fdc.h"
+#include "devices/apple2_fdc_rom.h"
+#include "devices/prodos_hdd.h"
+#include "devices/prodos_hdc.h"
+#include "devices/prodos_hdc_rom.h"
+#include "devices/mockingboard.h"
+
+#ifdef APPLE2E
+#include "systems/apple2e.h"
+#define NAME               "apple2e"
+#define NUM_MODES          (256)
+#define sys_t              apple2e_t
+#define sys_screen_update  apple2e_screen_update
+#define sys_render_line    apple2e_render_line
+#define SCREEN_HEIGHT      APPLE2E_SCREEN_HEIGHT
+#define CHARACTER_ROM_SIZE (0x1000)
+#else
+#include "systems/apple2.h"
+#define NAME               "apple2"
+#define NUM_MODES          (64)
+#define sys_t              apple2_t
+#define sys_screen_update  apple2_screen_update
+#define sys_render_line    apple2_render_line
+#define SCREEN_HEIGHT      APPLE2_SCREEN_HEIGHT
+#define CHARACTER_ROM_SIZE (0x800)
+#endif
+#define PITCH (280)
+
+static uint8_t rom[0x4000], character_rom[0x1000], fdc_rom[0x100], hdc_rom[0x100];
+#ifdef APPLE2E
+static uint8_t keyboard_rom[0x800];
+#endif
+static sys_t sys;
+
+static void init(void) {
+#ifdef APPLE2E
+    apple2e_init(&sys, &(apple2e_desc_t){
+                           .roms = {
+                               .rom = {rom, sizeof(rom)},
+                               .character_rom = {character_rom, CHARACTER_ROM_SIZE},
+                               .keyboard_rom = {keyboard_rom, sizeof(keyboard_rom)},
+                               .fdc_rom = {fdc_rom, sizeof(fdc_rom)},
+                               .hdc_rom = {hdc_rom, sizeof(hdc_rom)},
+                           }});
+    for (size_t i = 0; i < sizeof(sys.aux_ram); i++) {
+        sys.aux_ram[i] = (uint8_t)rand();
+    }
+#else
+    apple2_init(&sys, &(apple2_desc_t){
+                          .roms = {
+                              .rom = {rom, sizeof(rom)},
+                              .character_rom = {character_rom, CHARACTER_ROM_SIZE},
+                              .fdc_rom = {fdc_rom, sizeof(fdc_rom)},
+                              .hdc_rom = {hdc_rom, sizeof(hdc_rom)},
+                          }});
+#endif
+    for (size_t i = 0; i < sizeof(sys.ram); i++) {
+        sys.ram[i] = (uint8_t)rand();
+    }
+    for (int i = 0; i < CHARACTER_ROM_SIZE; i++) {
+        sys.character_rom[i] = (uint8_t)rand();
+    }
+}
+
+static void set_mode(int mode) {
+    sys.text = mode & 1;
+    sys.mixed = (mode >> 1) & 1;
+    sys.page2 = (mode >> 2) & 1;
+    sys.hires = (mode >> 3) & 1;
+    sys.composite = (mode >> 4) & 1;
+    sys.shared_lines = (mode >> 5) & 1;
+#ifdef APPLE2E
+    sys.dhires = sys._80col = (mode >> 6) & 1;
+    sys.altcharset = (mode >> 7) & 1;
+#endif
+    sys.text_page1_dirty = sys.text_page2_dirty = true;
+    sys.hires_page1_dirty = sys.hires_page2_dirty = true;
+}
+
+int main(int argc, char** argv) {
+    const bool mixed_lores = (argc > 1) && (strcmp(argv[1], "--mixed-lores") == 0);
+    srand(1);
+    init();
+    int lines = 0, mismatches = 0;
+    uint8_t line[PITCH];
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        set_mode(mode);
+        // Rows the update doesn't render keep this pattern
+        memset(sys.fb, 0xAA, sizeof(sys.fb));
+        sys_screen_update(&sys);
+        const bool lores_text = sys.mixed && !sys.text && !sys.hires;
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            if ((lores_text && (y >= 160)) != mixed_lores) {
+                continue;
+            }
+            sys_render_line(&sys, y, line);
+            lines++;
+            if (memcmp(line, &sys.fb[sys.fb_line[y] * PITCH], PITCH) != 0) {
+                if (mismatches++ < 5) {
+                    printf("mismatch in mode %02X line %d\n", mode, y);
+                }
+            }
+        }
+    }
+    printf("%s: %d lines compared, %d mismatches\n", NAME, lines, mismatches);
+    return mismatches ? 1 : 0;
+}
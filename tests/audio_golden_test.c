@@ -0,0 +1,171 @@
+// System audio output against golden hashes
+//
+// Renders 10 emulated seconds of system audio through the frontends'
+// callback and hashes the 8-bit samples: an Apple II speaker with random
+// toggles, the same with a Mockingboard playing, and an Oric PSG playing
+// tones, noise and envelopes, with a register write every 20 ms and a rate
+// adjustment halfway. PSG writes go through the systems' own render-then-
+// write path, speaker toggles are timestamped like bus accesses. The float
+// hashes were taken from the float implementation before the fixed-point
+// path was added, so the host default must stay bit-identical to it. Built
+// again with RESAMPLER_FIXEDPOINT=1, where the hashes pin the Pico output.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico_host.h"
+#include "chips/chips_common.h"
+#include "chips/wdc65C02cpu.h"
+#include "chips/resampler.h"
+#include "chips/beeper.h"
+#include "chips/mos6522via.h"
+#include "chips/ay38910psg.h"
+#include "chips/kbd.h"
+#include "chips/mem.h"
+#include "chips/clk.h"
+#include "devices/apple2_lc.h"
+#include "devices/disk2_nib.h"
+#include "devices/disk2_fdd.h"
+#include "devices/disk2_fdc.h"
+#include "devices/apple2_fdc_rom.h"
+#include "devices/prodos_hdd.h"
+#include "devices/prodos_hdc.h"
+#include "devices/prodos_hdc_rom.h"
+#include "devices/mockingboard.h"
+#include "devices/oric_td.h"
+#include "devices/oric_fdc_rom.h"
+#include "systems/apple2.h"
+#include "systems/oric.h"
+
+#define SECONDS     (10)
+#define SLICE_TICKS (1000)  // Audio flushed per slice, like the frontends' 1 ms slices
+#define FRAME_TICKS (20000)
+
+typedef struct {
+    const char* name;
+    uint32_t hash;
+} golden_t;
+
+#if RESAMPLER_FIXEDPOINT
+static const golden_t golden[3] = {
+    {"apple2 speaker", 0xFD670718}, {"apple2 mockingboard", 0x94F6B513}, {"oric psg", 0x03C52EA4}};
+#else
+static const golden_t golden[3] = {
+    {"apple2 speaker", 0x7C4A0660}, {"apple2 mockingboard", 0x56CCB831}, {"oric psg", 0xD72E1B9C}};
+#endif
+
+static uint8_t apple2_rom[0x4000], character_rom[0x800], fdc_rom[0x100], hdc_rom[0x100];
+static uint8_t oric_rom[0x4000], boot_rom[0x200];
+static apple2_t apple2;
+static oric_t oric;
+static uint32_t hash, num_samples, rng;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+// FNV-1a over every sample the system hands out
+static void audio_callback(const uint8_t* samples, int n, void* user_data) {
+    (void)user_data;
+    for (int i = 0; i < n; i++) {
+        hash = (hash ^ samples[i]) * 16777619u;
+    }
+    num_samples += n;
+}
+
+static void start(void) {
+    hash = 2166136261u;
+    num_samples = 0;
+    rng = 1;
+}
+
+// Tones on all three channels, noise on A, the envelope on B, then new values every frame
+static void write_psg(ay38910psg_t* psg, uint32_t frame) {
+    static const uint8_t regs[14] = {0x50, 0, 0x80, 0, 0x33, 1, 7, 0x30, 15, 0x10, 10, 0, 2, 10};
+    if (frame == 0) {
+        for (int r = 0; r < 14; r++) {
+            ay38910psg_latch_address(psg, (uint8_t)r);
+            ay38910psg_write(psg, regs[r]);
+        }
+        return;
+    }
+    const uint8_t r = (uint8_t)(next_random() % 14);
+    uint8_t v = (uint8_t)next_random();
+    if (r == 7) {
+        v &= 0x3F;  // Keep the I/O ports as inputs
+    } else if (r == 13) {
+        v &= 0x0F;
+    }
+    ay38910psg_latch_address(psg, r);
+    ay38910psg_write(psg, v);
+}
+
+static uint32_t run_apple2(bool mockingboard) {
+    apple2_init(&apple2, &(apple2_desc_t){
+                             .mockingboard_enabled = mockingboard,
+                             .audio = {.callback = {.func = audio_callback}, .sample_rate = 22050},
+                             .roms = {
+                                 .rom = {apple2_rom, sizeof(apple2_rom)},
+                                 .character_rom = {character_rom, sizeof(character_rom)},
+                                 .fdc_rom = {fdc_rom, sizeof(fdc_rom)},
+                                 .hdc_rom = {hdc_rom, sizeof(hdc_rom)},
+                             }});
+    start();
+    uint32_t next_toggle = 100;
+    for (uint32_t tick = 0; tick < SECONDS * APPLE2_FREQUENCY; tick++) {
+        // Bus accesses happen within a tick, before apple2_tick() counts it
+        if (tick == next_toggle) {
+            // A speaker access
+            beeper_toggle_at(&apple2.beeper, apple2.system_ticks);
+            next_toggle += 20 + next_random() % 3000;
+        }
+        if (mockingboard && ((tick % FRAME_TICKS) == 0)) {
+            // A PSG register write, samples up to this tick still use the old registers
+            _apple2_render_audio(&apple2, apple2.system_ticks + 1);
+            write_psg(&apple2.mb.psg[0], tick / FRAME_TICKS);
+            write_psg(&apple2.mb.psg[1], tick / FRAME_TICKS);
+        }
+        apple2_tick(&apple2);
+        if ((tick % SLICE_TICKS) == 0) {
+            apple2_flush_audio(&apple2);
+            apple2_set_audio_rate_adjust(&apple2, (tick < SECONDS * APPLE2_FREQUENCY / 2) ? 0 : 1234);
+        }
+    }
+    return hash;
+}
+
+static uint32_t run_oric(void) {
+    oric_init(&oric, &(oric_desc_t){
+                         .audio = {.callback = {.func = audio_callback}, .sample_rate = 22050},
+                         .roms = {.rom = {oric_rom, sizeof(oric_rom)}, .boot_rom = {boot_rom, sizeof(boot_rom)}},
+                     });
+    start();
+    for (uint32_t tick = 0; tick < SECONDS * ORIC_FREQUENCY; tick++) {
+        if ((tick % FRAME_TICKS) == 0) {
+            _oric_render_audio(&oric, oric.system_ticks + 1);
+            write_psg(&oric.psg, tick / FRAME_TICKS);
+        }
+        oric_tick(&oric);
+        if ((tick % SLICE_TICKS) == 0) {
+            oric_flush_audio(&oric);
+        }
+    }
+    return hash;
+}
+
+int main(void) {
+    uint32_t hashes[3];
+    hashes[0] = run_apple2(false);
+    hashes[1] = run_apple2(true);
+    hashes[2] = run_oric();
+    int failures = 0;
+    for (int i = 0; i < 3; i++) {
+        const bool ok = hashes[i] == golden[i].hash;
+        printf("%-20s %08X %s\n", golden[i].name, hashes[i], ok ? "ok" : "MISMATCH");
+        failures += !ok;
+    }
+    printf("%s path: %s\n", RESAMPLER_FIXEDPOINT ? "fixed-point" : "float", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
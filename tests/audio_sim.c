@@ -0,0 +1,220 @@
+// Pico audio stream against a simulated fixed-rate sink
+//
+// Builds the frontend's audio.c against the host SDK stand-ins in stub/ and
+// drives it the way the Apple II frontend does: an Apple II (idle bus) runs
+// in slices and hands AUDIO_BUFFER_SIZE sample blocks to audio_push(), while
+// a simulated DMA raises the buffer interrupt on its own clock, off by the
+// sink's clock error, and plays the buffer the interrupt queued. Emulating
+// a slice costs 0.3-0.9x real time. Without AUDIO_PACING the loop runs 1 ms
+// slices and sleeps for the rest, like the timer-paced loop. With it the
+// loop asks audio_get_pacing_ticks() and waits for the next interrupt when
+// that says 0, and takes a 15 ms stall every few seconds.
+//
+// The speaker toggles every 50 ms, the time from the toggle to its step
+// leaving the ring (the interrupt that pulls it) is measured, playout adds
+// one buffer. Per sink clock error it prints the latency, underruns,
+// overruns and the ring fill, and fails on any underrun or overrun, an
+// average latency off the expected one by more than 25%, and with
+// AUDIO_PACING on the emulation running ahead of the buffered samples.
+// Runs 10 simulated minutes per clock error, --quick runs 1 minute.
+#include "pico/stdlib.h"
+#include "audio.c"
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "chips/chips_common.h"
+#include "chips/wdc65C02cpu.h"
+#include "chips/resampler.h"
+#include "chips/beeper.h"
+#include "chips/mos6522via.h"
+#include "chips/ay38910psg.h"
+#include "chips/kbd.h"
+#include "chips/mem.h"
+#include "chips/clk.h"
+#include "devices/apple2_lc.h"
+#include "devices/disk2_nib.h"
+#include "devices/disk2_fdd.h"
+#include "devices/disk2_fdc.h"
+#include "devices/apple2_fdc_rom.h"
+#include "devices/prodos_hdd.h"
+#include "devices/prodos_hdc.h"
+#include "devices/prodos_hdc_rom.h"
+#include "devices/mockingboard.h"
+#include "systems/apple2.h"
+
+#define SAMPLE_RATE       (22050)
+#define TOGGLE_TICKS      (APPLE2_FREQUENCY / 20)
+#define STALL             (0.015)
+#define MAX_LEAD          (0.002)  // Emulated time ahead of the buffered samples with AUDIO_PACING
+#define LATENCY_TOLERANCE (0.25)
+
+static const double sink_ppm[] = {0.0, 3000.0, -3000.0};
+
+static uint8_t rom[0x4000], character_rom[0x800], fdc_rom[0x100], hdc_rom[0x100];
+static apple2_t sys;
+
+// Sink state, advanced up to the wall time with sink_run()
+static struct {
+    double period;    // Seconds per DMA buffer
+    double next;      // Wall time of the next buffer interrupt
+    uint32_t min_fill, max_fill;
+    // Pending speaker step
+    bool waiting;
+    bool level;
+    double toggle_time;
+    // Latency from the toggle to the interrupt that takes the step out of the ring
+    double sum, min, max;
+    int count;
+} sink;
+
+static void sink_run(double now) {
+    while (sink.next <= now) {
+        irq_host_handlers[DMA_IRQ_1]();
+        // The interrupt queued the buffer it filled last time, the one it just filled plays next
+        const uint8_t* buf = audio_buffers[1 - cur_audio_buffer];
+        if (sink.waiting) {
+            for (int i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+                if ((buf[i] >= 128) == sink.level) {
+                    const double latency = sink.next - sink.toggle_time;
+                    sink.sum += latency;
+                    sink.min = (latency < sink.min) ? latency : sink.min;
+                    sink.max = (latency > sink.max) ? latency : sink.max;
+                    sink.count++;
+                    sink.waiting = false;
+                    break;
+                }
+            }
+        }
+        const uint32_t fill = ring_write - ring_read;
+        if (ring_primed) {
+            sink.min_fill = (fill < sink.min_fill) ? fill : sink.min_fill;
+            sink.max_fill = (fill > sink.max_fill) ? fill : sink.max_fill;
+        }
+        sink.next += sink.period;
+    }
+}
+
+static void push_audio(const uint8_t* samples, int num_samples, void* user_data) {
+    (void)user_data;
+    audio_push(samples, num_samples);
+}
+
+// Reset the stream and the system between runs
+static void init(double ppm) {
+    memset(audio_ring, 0, sizeof(audio_ring));
+    ring_write = ring_read = 0;
+    ring_primed = false;
+    ring_last = 128;
+    ring_drift = 0;
+    rate_adjust = 0;
+    ring_underruns = ring_overruns = ring_fill = 0;
+    pacing_frac = 0;
+    cur_audio_buffer = last_audio_buffer = 0;
+    dma_host_claimed = 0;
+    audio_init(0, SAMPLE_RATE);
+    apple2_init(&sys, &(apple2_desc_t){
+                          .audio = {.callback = {.func = push_audio}, .num_samples = AUDIO_BUFFER_SIZE,
+                                    .sample_rate = SAMPLE_RATE},
+                          .roms = {
+                              .rom = {rom, sizeof(rom)},
+                              .character_rom = {character_rom, sizeof(character_rom)},
+                              .fdc_rom = {fdc_rom, sizeof(fdc_rom)},
+                              .hdc_rom = {hdc_rom, sizeof(hdc_rom)},
+                          }});
+    memset(&sink, 0, sizeof(sink));
+    sink.period = AUDIO_BUFFER_SIZE / (SAMPLE_RATE * (1.0 + ppm * 1e-6));
+    sink.next = sink.period;
+    sink.min_fill = UINT32_MAX;
+    sink.min = 1e9;
+}
+
+// Run num_ticks ticks starting at wall time now, toggling the speaker on schedule, returns the wall time it took
+static double run_slice(double now, uint32_t num_ticks) {
+    const double cost = num_ticks / (double)APPLE2_FREQUENCY * (0.3 + 0.6 * rand() / RAND_MAX);
+    for (uint32_t i = 0; i < num_ticks; i++) {
+        apple2_tick(&sys);
+        // A speaker access on the bus, the measurement waits for the previous step
+        if (((sys.system_ticks % TOGGLE_TICKS) == 0) && !sink.waiting) {
+            beeper_toggle_at(&sys.beeper, sys.system_ticks);
+            sink.level = !sink.level;
+            sink.waiting = true;
+            sink.toggle_time = now + cost * (i + 1) / num_ticks;
+        }
+    }
+    return cost;
+}
+
+static int run(double ppm, double seconds) {
+    init(ppm);
+    double now = 0.0;
+    uint64_t ticks = 0;
+    while (now < seconds) {
+#if AUDIO_PACING
+        const uint32_t num_ticks = audio_get_pacing_ticks(APPLE2_FREQUENCY);
+        if (num_ticks == 0) {
+            // __wfi() until the next buffer interrupt
+            now = sink.next;
+            sink_run(now);
+            continue;
+        }
+        now += run_slice(now, num_ticks);
+        ticks += num_ticks;
+        sink_run(now);
+        apple2_flush_audio(&sys);
+        if ((rand() % 2000) == 0) {
+            now += STALL;
+        }
+#else
+        const double start = now;
+        const uint32_t num_ticks = clk_us_to_ticks(APPLE2_FREQUENCY, 1000);
+        now += run_slice(now, num_ticks);
+        ticks += num_ticks;
+        sink_run(now);
+        apple2_flush_audio(&sys);
+        apple2_set_audio_rate_adjust(&sys, audio_get_rate_adjust());
+        now = start + 0.001;
+#endif
+        sink_run(now);
+    }
+
+    audio_stats_t stats;
+    audio_get_stats(&stats);
+    const double latency = sink.sum / sink.count;
+    // Pacing keeps the ring below the target, the rate control keeps it at the target
+    const double expected = (double)(AUDIO_RING_TARGET + (AUDIO_PACING ? 0 : AUDIO_BUFFER_SIZE)) / SAMPLE_RATE;
+    // Emulated time ahead of the samples taken from the ring, with pacing at most what's buffered
+    const double lead = (double)ticks / APPLE2_FREQUENCY - (double)ring_read / SAMPLE_RATE;
+    const double max_lead = (double)(AUDIO_RING_TARGET + AUDIO_BUFFER_SIZE) / SAMPLE_RATE + MAX_LEAD;
+    printf("sink %+5.0f ppm: latency %.1f ms (%.1f-%.1f, n=%d) +%.1f ms playout, underruns %u, overruns %u, "
+           "fill %u-%u, emulated ahead %+.1f ms\n",
+           ppm, latency * 1e3, sink.min * 1e3, sink.max * 1e3, sink.count, sink.period * 1e3, stats.underruns,
+           stats.overruns, sink.min_fill, sink.max_fill, lead * 1e3);
+    int failures = 0;
+    if ((stats.underruns > 0) || (stats.overruns > 0)) {
+        printf("FAIL underruns or overruns\n");
+        failures++;
+    }
+    if (fabs(latency - expected) > expected * LATENCY_TOLERANCE) {
+        printf("FAIL latency, expected about %.1f ms\n", expected * 1e3);
+        failures++;
+    }
+    if (AUDIO_PACING && ((lead < 0.0) || (lead > max_lead))) {
+        printf("FAIL emulated and consumed time drift apart\n");
+        failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    const double seconds = ((argc > 1) && (strcmp(argv[1], "--quick") == 0)) ? 60.0 : 600.0;
+    printf("AUDIO_BUFFER_SIZE %d, AUDIO_RING_TARGET %d, AUDIO_PACING %d\n", AUDIO_BUFFER_SIZE, AUDIO_RING_TARGET,
+           AUDIO_PACING);
+    srand(7);
+    int failures = 0;
+    for (size_t i = 0; i < CHIPS_ARRAY_SIZE(sink_ppm); i++) {
+        failures += run(sink_ppm[i], seconds);
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
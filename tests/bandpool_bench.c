@@ -0,0 +1,156 @@
+// bandpool scaling
+//
+// Checks that every band of a frame is rendered exactly once for frames of
+// varying height, and that NTSC decoding and 4x scaling with scanlines give
+// byte-identical output on any number of threads. Then times both stages
+// per thread count and prints the speedup over one thread. Scaling needs as
+// many cores as threads, the online CPU count is printed with the results.
+// --quick runs fewer frames.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chips/chips_common.h"
+#include "util/bandpool.h"
+#include "util/fbconv.h"
+#include "util/ntsc.h"
+
+#define WIDTH  280  // Apple II pixels, 560 composite dots
+#define HEIGHT 192
+#define DOTS   (WIDTH * 2)
+
+static const int thread_counts[] = {1, 2, 4, 8, 16};
+
+static const uint32_t palette[16] = {
+    0xFF000000, 0xFFDD0033, 0xFF000099, 0xFFDD22DD, 0xFF007722, 0xFF555555, 0xFF2222FF, 0xFF66AAFF,
+    0xFF885500, 0xFFFF6600, 0xFFAAAAAA, 0xFFFF9988, 0xFF11DD00, 0xFFFFFF00, 0xFF44FF99, 0xFFFFFFFF,
+};
+
+static uint8_t fb[WIDTH / 2 * HEIGHT];      // 4bpp pixels
+static uint8_t dots[DOTS / 2 * HEIGHT];     // Composite dot stream, 4bpp
+static uint32_t decoded[DOTS * HEIGHT];
+static uint32_t decoded_ref[DOTS * HEIGHT];
+static uint8_t scaled[WIDTH * 4 * 4 * HEIGHT * 4];
+static uint8_t scaled_ref[WIDTH * 4 * 4 * HEIGHT * 4];
+static ntsc_t ntsc;
+static fbconv_t conv;
+static bandpool_t pool;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Frame of the coverage check, rows count how often they were rendered
+typedef struct {
+    int height;
+    int rows[300];
+    int out_of_range;
+} job_t;
+
+static void count_band(void* user_data, int y0, int y1) {
+    job_t* job = (job_t*)user_data;
+    if ((y0 < 0) || (y1 > job->height)) {
+        job->out_of_range++;
+    }
+    for (int y = y0; y < y1; y++) {
+        job->rows[y]++;
+    }
+}
+
+static void decode_band(void* user_data, int y0, int y1) {
+    (void)user_data;
+    ntsc_decode_band(&ntsc, dots, decoded, DOTS, true, NULL, NULL, y0, y1);
+}
+
+static void scale_band(void* user_data, int y0, int y1) {
+    (void)user_data;
+    fbconv_convert_band(&conv, fb, scaled, NULL, NULL, y0, y1);
+}
+
+int main(int argc, char** argv) {
+    bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    srand(1);
+    for (size_t i = 0; i < sizeof(fb); i++) {
+        fb[i] = (uint8_t)rand();
+    }
+    for (size_t i = 0; i < sizeof(dots); i++) {
+        dots[i] = ((rand() & 1) ? 0xF0 : 0) | ((rand() & 1) ? 0x0F : 0);
+    }
+    ntsc_init(&ntsc, &(ntsc_desc_t){.palette = palette});
+    fbconv_init(&conv, &(fbconv_desc_t){
+                           .width = WIDTH,
+                           .height = HEIGHT,
+                           .format = FBCONV_FORMAT_ARGB8888,
+                           .scale = 4,
+                           .scanlines = true,
+                           .palette = palette,
+                           .num_colors = 16,
+                       });
+    ntsc_decode(&ntsc, dots, decoded_ref, DOTS, HEIGHT, true, NULL, NULL);
+    fbconv_convert(&conv, fb, scaled_ref, NULL, NULL);
+
+    int failures = 0;
+    const int coverage_frames = quick ? 2000 : 100000;
+    const int timed_frames = quick ? 20 : 1000;
+    printf("%ld online CPUs\n", sysconf(_SC_NPROCESSORS_ONLN));
+    printf("threads  ntsc ms/frame  speedup  4x ms/frame  speedup\n");
+    double base_decode = 0.0, base_scale = 0.0;
+    for (size_t t = 0; t < CHIPS_ARRAY_SIZE(thread_counts); t++) {
+        if (!bandpool_start(&pool, &(bandpool_desc_t){.num_threads = thread_counts[t]})) {
+            printf("FAIL bandpool_start with %d threads\n", thread_counts[t]);
+            return 1;
+        }
+        // Every row of every frame exactly once, alternating between two frames' user data
+        static job_t jobs[2];
+        for (int f = 0; f < coverage_frames; f++) {
+            job_t* job = &jobs[f & 1];
+            memset(job, 0, sizeof(job_t));
+            job->height = 1 + (f * 37) % 280;
+            bandpool_run(&pool, job->height, count_band, job);
+            bool ok = job->out_of_range == 0;
+            for (int y = 0; y < 300; y++) {
+                ok &= job->rows[y] == (y < job->height);
+            }
+            if (!ok) {
+                printf("FAIL %d threads, frame %d of height %d\n", thread_counts[t], f, job->height);
+                failures++;
+                break;
+            }
+        }
+
+        memset(decoded, 0, sizeof(decoded));
+        memset(scaled, 0, sizeof(scaled));
+        bandpool_run(&pool, HEIGHT, decode_band, NULL);
+        bandpool_run(&pool, HEIGHT, scale_band, NULL);
+        if ((memcmp(decoded, decoded_ref, sizeof(decoded)) != 0) || (memcmp(scaled, scaled_ref, sizeof(scaled)) != 0)) {
+            printf("FAIL %d threads output differs from the single-threaded output\n", thread_counts[t]);
+            failures++;
+        }
+
+        double t0 = now();
+        for (int f = 0; f < timed_frames; f++) {
+            bandpool_run(&pool, HEIGHT, decode_band, NULL);
+        }
+        double t1 = now();
+        for (int f = 0; f < timed_frames; f++) {
+            bandpool_run(&pool, HEIGHT, scale_band, NULL);
+        }
+        double t2 = now();
+        bandpool_stop(&pool);
+
+        double decode_ms = (t1 - t0) * 1e3 / timed_frames;
+        double scale_ms = (t2 - t1) * 1e3 / timed_frames;
+        if (t == 0) {
+            base_decode = decode_ms;
+            base_scale = scale_ms;
+        }
+        printf("%7d %14.3f %8.2f %12.3f %8.2f\n", thread_counts[t], decode_ms, base_decode / decode_ms, scale_ms,
+               base_scale / scale_ms);
+    }
+    return failures ? 1 : 0;
+}
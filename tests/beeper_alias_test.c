@@ -0,0 +1,146 @@
+// Beeper aliasing, band-limited steps against point sampling
+//
+// Drives the beeper with square waves of a few kHz at the Apple II clock,
+// once point sampled through beeper_tick() and once through the
+// band-limited beeper_toggle_at() / beeper_flush() path, and measures the
+// share of the output energy that lies off the square wave's harmonics
+// (Hann-windowed FFT). That energy is aliasing: harmonics above Nyquist
+// folded back into the audio band. The band-limited path must stay below
+// MAX_ALIAS_DB and beat point sampling by MIN_GAIN_DB. Also checks that the
+// output doesn't depend on how often the beeper is flushed.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#include "chips/chips_common.h"
+#include "chips/resampler.h"
+#include "chips/beeper.h"
+
+#define TICK_HZ      (1021800)  // Apple II
+#define SOUND_HZ     (22050)
+#define FFT_SIZE     (16384)
+#define SKIP         (4410)  // Samples before the analysis window
+#define MAX_ALIAS_DB (-18.0)
+#define MIN_GAIN_DB  (8.0)
+
+static const double frequencies[] = {1200.0, 3700.0, 6100.0};
+
+static double point[SKIP + FFT_SIZE];
+static double blep[SKIP + FFT_SIZE];
+
+static void fft(double complex* x, int n) {
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            double complex t = x[i];
+            x[i] = x[j];
+            x[j] = t;
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        double complex w = cexp(-2.0 * M_PI * I / len);
+        for (int i = 0; i < n; i += len) {
+            double complex wk = 1.0;
+            for (int k = 0; k < len / 2; k++) {
+                double complex u = x[i + k], v = x[i + k + len / 2] * wk;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                wk *= w;
+            }
+        }
+    }
+}
+
+// Energy off the odd harmonics of f0 relative to the total, in dB
+static double alias_db(const double* samples, double f0) {
+    static double complex x[FFT_SIZE];
+    double mean = 0.0;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        mean += samples[SKIP + i];
+    }
+    mean /= FFT_SIZE;
+    for (int i = 0; i < FFT_SIZE; i++) {
+        x[i] = (samples[SKIP + i] - mean) * (0.5 - 0.5 * cos(2.0 * M_PI * i / (FFT_SIZE - 1)));
+    }
+    fft(x, FFT_SIZE);
+    double total = 0.0, alias = 0.0;
+    for (int i = 0; i < FFT_SIZE / 2; i++) {
+        double f = (double)i * SOUND_HZ / FFT_SIZE;
+        double e = creal(x[i]) * creal(x[i]) + cimag(x[i]) * cimag(x[i]);
+        bool harmonic = false;
+        for (double h = f0; h < SOUND_HZ / 2; h += 2.0 * f0) {
+            harmonic |= fabs(f - h) < 40.0;
+        }
+        total += e;
+        alias += harmonic ? 0.0 : e;
+    }
+    return 10.0 * log10(alias / total);
+}
+
+// Render the square wave both ways, the band-limited path flushed every slice ticks
+static void render(double f0, uint32_t slice) {
+    static beeper_t a, b;
+    const beeper_desc_t desc = {.tick_hz = TICK_HZ, .sound_hz = SOUND_HZ, .base_volume = 1.0f};
+    beeper_init(&a, &desc);
+    beeper_init(&b, &desc);
+    const double half = TICK_HZ / (2.0 * f0);
+    double next = half;
+    int na = 0, nb = 0;
+    resampler_level_t out[64];
+    // Start at a nonzero tick, the event timestamps are absolute
+    for (uint32_t i = 0, tick = 12345; (na < SKIP + FFT_SIZE) || (nb < SKIP + FFT_SIZE); i++, tick++) {
+        if (i >= next) {
+            next += half;
+            beeper_toggle(&a);
+            beeper_toggle_at(&b, tick);
+        }
+        if (beeper_tick(&a) && (na < SKIP + FFT_SIZE)) {
+            point[na++] = (double)a.sample / RESAMPLER_ONE;
+        }
+        if ((i % slice) == slice - 1) {
+            int n;
+            do {
+                n = beeper_flush(&b, tick + 1, out, 64);
+                for (int k = 0; (k < n) && (nb < SKIP + FFT_SIZE); k++) {
+                    blep[nb++] = (double)out[k] / RESAMPLER_ONE;
+                }
+            } while (n == 64);
+        }
+    }
+}
+
+int main(void) {
+    int failures = 0;
+    printf("frequency  point sampled  band-limited\n");
+    for (size_t i = 0; i < CHIPS_ARRAY_SIZE(frequencies); i++) {
+        const double f0 = frequencies[i];
+        render(f0, 1022);
+        double point_db = alias_db(point, f0);
+        double blep_db = alias_db(blep, f0);
+        printf("%6.0f Hz %11.1f dB %11.1f dB\n", f0, point_db, blep_db);
+        if ((blep_db > MAX_ALIAS_DB) || (point_db - blep_db < MIN_GAIN_DB)) {
+            printf("FAIL aliasing at %.0f Hz\n", f0);
+            failures++;
+        }
+        // The same samples with a flush every 17 and every 5000 ticks
+        static double reference[SKIP + FFT_SIZE];
+        memcpy(reference, blep, sizeof(blep));
+        render(f0, 17);
+        bool same = memcmp(reference, blep, sizeof(blep)) == 0;
+        render(f0, 5000);
+        same &= memcmp(reference, blep, sizeof(blep)) == 0;
+        if (!same) {
+            printf("FAIL output depends on the flush interval at %.0f Hz\n", f0);
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
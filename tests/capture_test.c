@@ -0,0 +1,195 @@
+// recorder and wavcapture output
+//
+// Runs both capture sinks on top of ringwriter and reads their files back:
+// the recorder must write exactly the frames it accepted, in order and
+// expanded through the palette (raw RGB24 and Y4M), the WAV capture exactly
+// the accepted sample blocks with a header patched to the final sizes. The
+// producer runs paced for the first half and in a burst for the second, so
+// some frames and blocks get dropped, the checks hold either way.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "chips/chips_common.h"
+#include "util/ringwriter.h"
+#include "util/recorder.h"
+#include "util/wavcapture.h"
+
+#define WIDTH  240  // Oric
+#define HEIGHT 224
+#define PITCH  (WIDTH / 2)
+#define FRAMES 300
+#define BLOCKS 20000
+
+static const uint32_t palette[8] = {
+    0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF, 0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF,
+};
+
+static recorder_t rec;
+static wavcapture_t cap;
+static uint8_t fb[PITCH * HEIGHT];
+static bool accepted[BLOCKS];
+static int failures;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+static uint8_t* read_file(FILE* file, long* size) {
+    fflush(file);
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    rewind(file);
+    uint8_t* data = malloc(*size + 1);
+    if (fread(data, 1, *size, file) != (size_t)*size) {
+        *size = 0;
+    }
+    fclose(file);
+    return data;
+}
+
+// Frame n shows color n % 8 with a diagonal of color 7 - n % 8
+static void make_frame(int n) {
+    memset(fb, (n % 8) * 0x11, sizeof(fb));
+    for (int y = 0; y < HEIGHT; y++) {
+        uint8_t* p = &fb[y * PITCH + (y % PITCH)];
+        *p = (uint8_t)((*p & 0xF0) | (7 - n % 8));
+    }
+}
+
+static uint32_t frame_color(int n, int x, int y) {
+    return palette[((x & 1) && (x / 2 == y % PITCH)) ? 7 - n % 8 : n % 8];
+}
+
+static void test_recorder(recorder_format_t format) {
+    const bool y4m = (format == RECORDER_FORMAT_Y4M);
+    FILE* file = tmpfile();
+    check(recorder_start(&rec, &(recorder_desc_t){.width = WIDTH,
+                                                  .height = HEIGHT,
+                                                  .frame_rate_num = 50,
+                                                  .format = format,
+                                                  .palette = palette,
+                                                  .num_colors = 8,
+                                                  .file = file}),
+          "recorder_start");
+    for (int n = 0; n < FRAMES; n++) {
+        make_frame(n);
+        accepted[n] = recorder_submit(&rec, fb, NULL);
+        if (n < FRAMES / 2) {
+            usleep(2000);
+        }
+    }
+    recorder_stop(&rec);
+    const unsigned submitted = atomic_load(&rec.frames_submitted);
+    const unsigned dropped = atomic_load(&rec.frames_dropped);
+    const unsigned written = atomic_load(&rec.frames_written);
+    printf("%s: %u frames submitted, %u dropped\n", y4m ? "y4m" : "rgb", submitted, dropped);
+    check((submitted == FRAMES) && (written == submitted - dropped), "recorder counters");
+
+    long size;
+    uint8_t* data = read_file(file, &size);
+    const char* header = "YUV4MPEG2 W240 H224 F50:1 Ip A1:1 C444\n";
+    size_t pos = y4m ? strlen(header) : 0;
+    check(!y4m || (memcmp(data, header, pos) == 0), "y4m header");
+    const size_t frame_size = (y4m ? 6 : 0) + (size_t)WIDTH * HEIGHT * 3;
+    check(size == (long)(pos + written * frame_size), "recorder file size");
+    for (int n = 0; (n < FRAMES) && (pos + frame_size <= (size_t)size); n++) {
+        if (!accepted[n]) {
+            continue;
+        }
+        const uint8_t* frame = &data[pos];
+        bool ok = !y4m || (memcmp(frame, "FRAME\n", 6) == 0);
+        for (int y = 0; ok && (y < HEIGHT); y++) {
+            for (int x = 0; ok && (x < WIDTH); x++) {
+                uint32_t c = frame_color(n, x, y);
+                uint8_t rgb[3] = {(c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF};
+                if (y4m) {
+                    uint8_t yuv[3];
+                    _recorder_rgb_to_yuv(c, yuv);
+                    const size_t plane = (size_t)WIDTH * HEIGHT;
+                    const size_t i = 6 + (size_t)y * WIDTH + x;
+                    ok = (frame[i] == yuv[0]) && (frame[i + plane] == yuv[1]) && (frame[i + 2 * plane] == yuv[2]);
+                } else {
+                    ok = memcmp(&frame[((size_t)y * WIDTH + x) * 3], rgb, 3) == 0;
+                }
+            }
+        }
+        if (!ok) {
+            printf("FAIL recorded frame %d\n", n);
+            failures++;
+            break;
+        }
+        pos += frame_size;
+    }
+    free(data);
+}
+
+static void test_wavcapture(void) {
+    FILE* file = tmpfile();
+    check(wavcapture_start(&cap, &(wavcapture_desc_t){.sample_rate = 44100, .file = file}), "wavcapture_start");
+    // Blocks of 1..1023 samples counting up, every other one through the callback
+    uint8_t block[1024];
+    uint8_t value = 0;
+    uint32_t expected_size = 0;
+    for (int n = 0; n < BLOCKS; n++) {
+        int len = 1 + (n * 37) % 1023;
+        for (int i = 0; i < len; i++) {
+            block[i] = (uint8_t)(value + i);
+        }
+        if (n & 1) {
+            unsigned dropped = atomic_load(&cap.blocks_dropped);
+            wavcapture_callback(block, len, &cap);
+            accepted[n] = atomic_load(&cap.blocks_dropped) == dropped;
+        } else {
+            accepted[n] = wavcapture_submit(&cap, block, len);
+        }
+        if (accepted[n]) {
+            value += len;
+            expected_size += len;
+        }
+        if ((n < BLOCKS / 2) && ((n % 16) == 0)) {
+            usleep(1000);
+        }
+    }
+    wavcapture_stop(&cap);
+    printf("wav: %u blocks submitted, %u dropped\n", atomic_load(&cap.blocks_submitted),
+           atomic_load(&cap.blocks_dropped));
+    check((atomic_load(&cap.blocks_submitted) == BLOCKS) && (cap.samples_written == expected_size),
+          "wavcapture counters");
+
+    long size;
+    uint8_t* data = read_file(file, &size);
+    const uint32_t pad = expected_size & 1;
+    check(size == (long)(WAVCAPTURE_HEADER_SIZE + expected_size + pad), "wav file size");
+    uint32_t riff_size, data_size, sample_rate;
+    memcpy(&riff_size, &data[4], 4);
+    memcpy(&sample_rate, &data[24], 4);
+    memcpy(&data_size, &data[40], 4);
+    check((memcmp(data, "RIFF", 4) == 0) && (memcmp(&data[8], "WAVEfmt ", 8) == 0) &&
+              (memcmp(&data[36], "data", 4) == 0),
+          "wav chunk ids");
+    check((riff_size == 36 + expected_size + pad) && (data_size == expected_size) && (sample_rate == 44100),
+          "wav header sizes");
+    // The accepted blocks count up without gaps
+    for (uint32_t i = 0; i < expected_size; i++) {
+        if (data[WAVCAPTURE_HEADER_SIZE + i] != (uint8_t)i) {
+            printf("FAIL wav sample %u\n", i);
+            failures++;
+            break;
+        }
+    }
+    free(data);
+}
+
+int main(void) {
+    test_recorder(RECORDER_FORMAT_RGB);
+    test_recorder(RECORDER_FORMAT_Y4M);
+    test_wavcapture();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
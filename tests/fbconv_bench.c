@@ -0,0 +1,114 @@
+// fbconv throughput per output format and scale
+//
+// Converts an Apple II sized framebuffer (280 x 192, 4 bits per pixel) with
+// every format, scale and scanline setting, checks the output against a
+// plain per-pixel palette lookup and prints the frames and output bytes per
+// second. --quick only runs the check and a short timing pass.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chips/chips_common.h"
+#include "util/fbconv.h"
+
+#define WIDTH  280
+#define HEIGHT 192
+
+static const uint32_t palette[16] = {
+    0xFF000000, 0xFFDD0033, 0xFF000099, 0xFFDD22DD, 0xFF007722, 0xFF555555, 0xFF2222FF, 0xFF66AAFF,
+    0xFF885500, 0xFFFF6600, 0xFFAAAAAA, 0xFFFF9988, 0xFF11DD00, 0xFFFFFF00, 0xFF44FF99, 0xFFFFFFFF,
+};
+
+static uint8_t fb[WIDTH / 2 * HEIGHT];
+static uint8_t out[WIDTH * FBCONV_MAX_SCALE * 4 * HEIGHT * FBCONV_MAX_SCALE];
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint32_t dim(uint32_t color, uint8_t level) {
+    uint32_t r = (((color >> 16) & 0xFF) * level) >> 8;
+    uint32_t g = (((color >> 8) & 0xFF) * level) >> 8;
+    uint32_t b = ((color & 0xFF) * level) >> 8;
+    return (color & 0xFF000000) | (r << 16) | (g << 8) | b;
+}
+
+// Expected output pixel at (x, y) of the scaled image
+static bool check_pixel(const uint8_t* p, fbconv_format_t format, int scale, bool scanlines, int x, int y) {
+    int sx = x / scale;
+    int sy = y / scale;
+    uint8_t byte = fb[sy * (WIDTH / 2) + sx / 2];
+    int index = (sx & 1) ? (byte & 0xF) : (byte >> 4);
+    bool dimmed = scanlines && (scale > 1) && ((y % scale) == scale - 1);
+    uint32_t color = dimmed ? dim(palette[index], 128) : palette[index];
+    switch (format) {
+        case FBCONV_FORMAT_ARGB8888: {
+            uint32_t c;
+            memcpy(&c, p, 4);
+            return c == color;
+        }
+        case FBCONV_FORMAT_RGB565: {
+            uint16_t c;
+            memcpy(&c, p, 2);
+            return c == (((color >> 19) & 0x1F) << 11 | ((color >> 10) & 0x3F) << 5 | ((color >> 3) & 0x1F));
+        }
+        default:
+            return *p == (dimmed ? index + 16 : index);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    srand(1);
+    for (size_t i = 0; i < sizeof(fb); i++) {
+        fb[i] = (uint8_t)rand();
+    }
+
+    static const char* names[3] = {"ARGB8888", "RGB565", "INDEX8"};
+    static const int bpp[3] = {4, 2, 1};
+    static fbconv_t conv;
+    int failures = 0;
+    printf("%-8s scale scanlines  frames/s   MB/s out\n", "format");
+    for (int format = 0; format < 3; format++) {
+        for (int scale = 1; scale <= FBCONV_MAX_SCALE; scale++) {
+            for (int scanlines = 0; scanlines < ((scale > 1) ? 2 : 1); scanlines++) {
+                fbconv_init(&conv, &(fbconv_desc_t){
+                                       .width = WIDTH,
+                                       .height = HEIGHT,
+                                       .format = (fbconv_format_t)format,
+                                       .scale = scale,
+                                       .scanlines = scanlines,
+                                       .palette = palette,
+                                       .num_colors = 16,
+                                   });
+                memset(out, 0xAA, sizeof(out));
+                fbconv_convert(&conv, fb, out, NULL, NULL);
+                const int pitch = fbconv_pitch(&conv);
+                for (int y = 0; (y < HEIGHT * scale) && (failures < 10); y++) {
+                    for (int x = 0; x < WIDTH * scale; x++) {
+                        const uint8_t* p = out + (size_t)y * pitch + (size_t)x * bpp[format];
+                        if (!check_pixel(p, (fbconv_format_t)format, scale, scanlines, x, y)) {
+                            printf("FAIL %s scale %d scanlines %d at %d,%d\n", names[format], scale, scanlines, x, y);
+                            failures++;
+                            break;
+                        }
+                    }
+                }
+
+                const int frames = quick ? 20 : 2000;
+                double t0 = now();
+                for (int i = 0; i < frames; i++) {
+                    fbconv_convert(&conv, fb, out, NULL, NULL);
+                }
+                double dt = now() - t0;
+                printf("%-8s %5d %9s %9.0f %10.0f\n", names[format], scale, scanlines ? "yes" : "no", frames / dt,
+                       frames * (double)fbconv_size(&conv) / dt / 1e6);
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
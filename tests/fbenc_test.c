@@ -0,0 +1,177 @@
+// fbenc round trip
+//
+// Encodes a sequence of randomly modified frames with partial dirty row
+// masks and a scanline row index, decodes the stream again and compares
+// every decoded frame with the source. Also checks PackBits on random
+// runs, the decoder's bounds checks and chips_fb_dirty_spans().
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chips/chips_common.h"
+#include "util/fbenc.h"
+
+#define WIDTH  560  // Apple II, 280 bytes per row
+#define HEIGHT 192
+#define PITCH  (WIDTH / 2)
+#define FRAMES 200
+
+static uint8_t fb[PITCH * HEIGHT];
+static uint8_t expected[PITCH * HEIGHT];
+static uint8_t decoded[PITCH * HEIGHT];
+static size_t frame_sizes[FRAMES];
+static fbenc_t enc;
+
+static int failures;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+// The scanlines the encoder sees, rows of fb picked through lines
+static void apply_lines(const uint8_t* lines) {
+    for (int y = 0; y < HEIGHT; y++) {
+        memcpy(&expected[y * PITCH], &fb[(lines ? lines[y] : y) * PITCH], PITCH);
+    }
+}
+
+static void test_round_trip(void) {
+    FILE* file = tmpfile();
+    fbenc_init(&enc, &(fbenc_desc_t){.width = WIDTH, .height = HEIGHT, .file = file});
+    uint32_t dirty[CHIPS_FB_DIRTY_WORDS(HEIGHT)];
+    uint8_t lines[HEIGHT];
+    static uint8_t frames[FRAMES][PITCH * HEIGHT];
+    for (int frame = 0; frame < FRAMES; frame++) {
+        memset(dirty, 0, sizeof(dirty));
+        // Some rows change, some are flagged without changing
+        int changes = rand() % 6;
+        for (int i = 0; i < changes; i++) {
+            int y = rand() % HEIGHT;
+            chips_fb_dirty_set(dirty, y);
+            if (rand() & 1) {
+                int x = rand() % PITCH;
+                int len = 1 + rand() % (PITCH - x);
+                memset(&fb[y * PITCH + x], rand(), len);
+            }
+        }
+        if ((frame % 50) == 25) {
+            // Full screen change, every row flagged
+            for (size_t i = 0; i < sizeof(fb); i++) {
+                fb[i] = (uint8_t)rand();
+            }
+            memset(dirty, 0xFF, sizeof(dirty));
+        }
+        // Every third frame shows each pair of scanlines from one fb row, as Apple lores does
+        const uint8_t* frame_lines = NULL;
+        if ((frame % 3) == 0) {
+            for (int y = 0; y < HEIGHT; y++) {
+                lines[y] = (uint8_t)(y & ~1);
+            }
+            frame_lines = lines;
+            memset(dirty, 0xFF, sizeof(dirty));
+        } else if ((frame % 3) == 1) {
+            // Back from the row index, the rows it skipped are different now
+            memset(dirty, 0xFF, sizeof(dirty));
+        }
+        apply_lines(frame_lines);
+        memcpy(frames[frame], expected, sizeof(expected));
+        frame_sizes[frame] = fbenc_encode(&enc, fb, dirty, frame_lines);
+    }
+
+    long size = ftell(file);
+    rewind(file);
+    uint8_t* stream = malloc(size);
+    check(fread(stream, 1, size, file) == (size_t)size, "read back stream");
+    check((memcmp(stream, "RFB1", 4) == 0) && (stream[4] == (WIDTH & 0xFF)) && (stream[6] == HEIGHT),
+          "stream header");
+
+    size_t pos = 8;
+    memset(decoded, 0, sizeof(decoded));
+    for (int frame = 0; frame < FRAMES; frame++) {
+        size_t n = fbenc_decode_frame(stream + pos, size - pos, decoded, PITCH, HEIGHT);
+        if ((n == 0) || (n != frame_sizes[frame]) || (memcmp(decoded, frames[frame], sizeof(decoded)) != 0)) {
+            printf("FAIL decoded frame %d\n", frame);
+            failures++;
+            break;
+        }
+        pos += n;
+    }
+    check(pos == (size_t)size, "whole stream consumed");
+    // A frame without changes costs its 3 byte header
+    check(fbenc_encode(&enc, fb, NULL, NULL) == 3, "static frame size");
+    // The encoder writes to the file until here
+    fclose(file);
+    free(stream);
+}
+
+static void test_pack(void) {
+    uint8_t src[FBENC_MAX_ROW_BYTES], packed[FBENC_MAX_PACKED_ROW], frame[16 + FBENC_MAX_PACKED_ROW];
+    uint8_t row[FBENC_MAX_ROW_BYTES];
+    for (int i = 0; i < 5000; i++) {
+        int n = 1 + rand() % FBENC_MAX_ROW_BYTES;
+        for (int k = 0; k < n; k++) {
+            src[k] = ((k > 0) && (rand() % 3)) ? src[k - 1] : (uint8_t)rand();
+        }
+        size_t m = fbenc_pack(src, n, packed);
+        if (m > (size_t)(n + (n + 127) / 128)) {
+            printf("FAIL packed size %zu for %d bytes\n", m, n);
+            failures++;
+            return;
+        }
+        // One span at row 0, column 0
+        const uint8_t header[11] = {'F', 1, 0, 0, 0, 0, 0, (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)m, (uint8_t)(m >> 8)};
+        memcpy(frame, header, sizeof(header));
+        memcpy(frame + sizeof(header), packed, m);
+        if ((fbenc_decode_frame(frame, sizeof(header) + m, row, sizeof(row), 1) != sizeof(header) + m) ||
+            (memcmp(row, src, n) != 0)) {
+            printf("FAIL PackBits round trip of %d bytes\n", n);
+            failures++;
+            return;
+        }
+    }
+}
+
+static void test_decode_bounds(void) {
+    uint8_t rows[2 * PITCH];
+    // Span at row 5 of a 2 row framebuffer
+    uint8_t frame[] = {'F', 1, 0, 5, 0, 0, 0, 1, 0, 2, 0, 0, 0xAA};
+    check(fbenc_decode_frame(frame, sizeof(frame), rows, PITCH, 2) == 0, "span below the framebuffer rejected");
+    frame[3] = 1;
+    check((fbenc_decode_frame(frame, sizeof(frame), rows, PITCH, 2) == sizeof(frame)) && (rows[PITCH] == 0xAA),
+          "span in the last row decoded");
+    // Span past the end of the row
+    uint8_t wide[] = {'F', 1, 0, 0, 0, (uint8_t)(PITCH & 0xFF), (uint8_t)(PITCH >> 8), 1, 0, 2, 0, 0, 0xAA};
+    check(fbenc_decode_frame(wide, sizeof(wide), rows, PITCH, 2) == 0, "span past the row end rejected");
+    check(fbenc_decode_frame(frame, sizeof(frame) - 1, rows, PITCH, 2) == 0, "truncated frame rejected");
+}
+
+static void test_dirty_spans(void) {
+    uint32_t dirty[CHIPS_FB_DIRTY_WORDS(64)] = {0};
+    const int ys[] = {1, 2, 10, 20, 30, 40, 41};
+    for (size_t i = 0; i < CHIPS_ARRAY_SIZE(ys); i++) {
+        chips_fb_dirty_set(dirty, ys[i]);
+    }
+    chips_fb_span_t spans[8];
+    check((chips_fb_dirty_spans(dirty, 64, spans, 8) == 5) && (spans[4].y == 40) && (spans[4].height == 2),
+          "dirty spans");
+    // More runs than spans, the last span covers the remaining dirty rows
+    int n = chips_fb_dirty_spans(dirty, 64, spans, 3);
+    check((n == 3) && (spans[0].y == 1) && (spans[0].height == 2) && (spans[1].y == 10) && (spans[1].height == 1) &&
+              (spans[2].y == 20) && (spans[2].height == 22),
+          "dirty spans overflow");
+    check(chips_fb_dirty_spans(dirty, 64, spans, 0) == 0, "no spans");
+}
+
+int main(void) {
+    srand(1);
+    test_round_trip();
+    test_pack();
+    test_decode_bounds();
+    test_dirty_spans();
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
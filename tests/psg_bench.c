@@ -0,0 +1,164 @@
+// Oric PSG audio cost, per-tick stepping against block rendering
+//
+// Runs the AY-3-8910 for SECONDS emulated seconds at the Oric's 1 MHz with
+// a register write every 20 ms frame, once stepped per tick the way
+// oric_tick() used to (generators on their tick multiples, a sample every
+// 46 ticks) and once rendered in blocks up to each write and per 1 ms slice
+// with ay38910psg_render(), and prints the audio cost per emulated second of
+// each after subtracting the bare loop. Both paths must end with the same
+// generator state. Then runs an Oric with an idle bus in 1 ms slices and
+// prints the time per emulated second spent in oric_flush_audio() against
+// the whole slice. --quick runs 2 seconds instead of 60.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico_host.h"
+#include "chips/chips_common.h"
+#include "chips/wdc65C02cpu.h"
+#include "chips/resampler.h"
+#include "chips/mos6522via.h"
+#include "chips/ay38910psg.h"
+#include "chips/kbd.h"
+#include "chips/mem.h"
+#include "chips/clk.h"
+#include "devices/oric_td.h"
+#include "devices/disk2_nib.h"
+#include "devices/disk2_fdd.h"
+#include "devices/disk2_fdc.h"
+#include "devices/oric_fdc_rom.h"
+#include "systems/oric.h"
+
+#define TICK_HZ       (1000000)
+#define SAMPLE_TICKS  (46)  // Old fixed sample period, about 21739 Hz
+#define FRAME_TICKS   (20000)
+#define SLICE_TICKS   (1000)
+#define BLOCK_SAMPLES (32)
+
+static uint8_t samples[2048];
+static int pos;
+static uint8_t rom[0x4000], boot_rom[0x200];
+static oric_t sys;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void init_psg(ay38910psg_t* psg) {
+    ay38910psg_init(psg, &(ay38910psg_desc_t){.magnitude = 1.0f, .tick_hz = TICK_HZ, .sound_hz = 22050});
+    // Tones on all three channels, noise on A, the envelope on B
+    const uint8_t regs[14] = {0x50, 0, 0x80, 0, 0x33, 1, 7, 0x30, 15, 0x10, 10, 0, 2, 10};
+    for (int r = 0; r < 14; r++) {
+        ay38910psg_latch_address(psg, (uint8_t)r);
+        ay38910psg_write(psg, regs[r]);
+    }
+}
+
+static void render(ay38910psg_t* psg, uint32_t end_tick) {
+    resampler_level_t out[BLOCK_SAMPLES];
+    int n;
+    do {
+        n = ay38910psg_render(psg, end_tick, out, BLOCK_SAMPLES);
+        for (int i = 0; i < n; i++) {
+            samples[pos++ & 2047] = resampler_to_u8(out[i]);
+        }
+    } while (n == BLOCK_SAMPLES);
+}
+
+static bool same_generators(const ay38910psg_t* a, const ay38910psg_t* b) {
+    for (int i = 0; i < AY38910PSG_NUM_CHANNELS; i++) {
+        if ((a->tone[i].counter != b->tone[i].counter) || (a->tone[i].bit != b->tone[i].bit)) {
+            return false;
+        }
+    }
+    return (a->noise.counter == b->noise.counter) && (a->noise.rng == b->noise.rng) &&
+           (a->env.counter == b->env.counter) && (a->env.shape_counter == b->env.shape_counter) &&
+           (a->env.shape_state == b->env.shape_state);
+}
+
+static void audio_callback(const uint8_t* buf, int num_samples, void* user_data) {
+    (void)user_data;
+    samples[pos++ & 2047] = buf[num_samples - 1];
+}
+
+int main(int argc, char** argv) {
+    const uint32_t seconds = ((argc > 1) && (strcmp(argv[1], "--quick") == 0)) ? 2 : 60;
+    const uint32_t ticks = seconds * TICK_HZ;
+    static ay38910psg_t per_tick, block;
+    init_psg(&per_tick);
+    init_psg(&block);
+
+    double t0 = now();
+    int sample_counter = 0;
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        if ((tick & (AY38910PSG_CHANNEL_TICKS - 1)) == 0) {
+            ay38910psg_tick_channels(&per_tick);
+        }
+        if ((tick & (AY38910PSG_ENVELOPE_TICKS - 1)) == 0) {
+            ay38910psg_tick_envelope_generator(&per_tick);
+        }
+        if (++sample_counter == SAMPLE_TICKS) {
+            ay38910psg_tick_sample_generator(&per_tick);
+            samples[pos++ & 2047] = resampler_to_u8(per_tick.sample);
+            sample_counter = 0;
+        }
+        if ((tick % FRAME_TICKS) == 0) {
+            ay38910psg_latch_address(&per_tick, 0);
+            ay38910psg_write(&per_tick, (uint8_t)(tick >> 10));
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    const double per_tick_time = now() - t0;
+
+    // The per-tick path steps the generators at the start of a tick, the block path when it renders past it
+    t0 = now();
+    for (uint32_t tick = 0; tick < ticks; tick += SLICE_TICKS) {
+        if ((tick % FRAME_TICKS) == 0) {
+            render(&block, tick + 1);
+            ay38910psg_latch_address(&block, 0);
+            ay38910psg_write(&block, (uint8_t)(tick >> 10));
+        }
+        render(&block, tick + SLICE_TICKS);
+    }
+    const double block_time = now() - t0;
+
+    t0 = now();
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        if ((tick % FRAME_TICKS) == 0) {
+            samples[pos & 2047] = (uint8_t)tick;
+        }
+        __asm__ volatile("" ::: "memory");
+    }
+    const double loop_time = now() - t0;
+
+    int failures = 0;
+    if (!same_generators(&per_tick, &block)) {
+        printf("FAIL per-tick and block generator state differ\n");
+        failures++;
+    }
+    printf("PSG audio cost per emulated second: per-tick %.2f ms, block %.2f ms\n",
+           (per_tick_time - loop_time) * 1e3 / seconds, block_time * 1e3 / seconds);
+
+    oric_init(&sys, &(oric_desc_t){
+                        .audio = {.callback = {.func = audio_callback}},
+                        .roms = {.rom = {rom, sizeof(rom)}, .boot_rom = {boot_rom, sizeof(boot_rom)}},
+                    });
+    double flush_time = 0.0;
+    t0 = now();
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        for (int tick = 0; tick < SLICE_TICKS; tick++) {
+            oric_tick(&sys);
+        }
+        double t1 = now();
+        oric_flush_audio(&sys);
+        flush_time += now() - t1;
+    }
+    const double oric_time = now() - t0;
+    printf("Oric per emulated second: %.2f ms, %.2f ms of it in oric_flush_audio()\n", oric_time * 1e3 / seconds,
+           flush_time * 1e3 / seconds);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+// shmfb export and sequence lock
+//
+// Publishes frames with partial dirty row masks and checks what a reader
+// sees through the mapped segment: the rows, row_frame and dirty_rows after
+// each publish, the lines row index, and under a concurrent reader thread
+// that every frame read inside the sequence lock is consistent (each row
+// holds the contents of the frame row_frame says last changed it).
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "chips/chips_common.h"
+#include "util/shmfb.h"
+
+#define WIDTH  240  // Oric, 120 bytes per row
+#define HEIGHT 224
+#define PITCH  (WIDTH / 2)
+#define FRAMES 20000
+
+static const uint32_t palette[8] = {
+    0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF, 0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF,
+};
+
+static uint8_t fb[PITCH * HEIGHT];
+static char name[SHMFB_MAX_NAME];
+static atomic_bool done;
+static int failures;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+static uint8_t row_value(uint32_t frame, int y) { return (uint8_t)(frame * 7 + y); }
+
+// Publish frame with random dirty rows, each dirty row filled with row_value(frame, y)
+static void publish(shmfb_t* shm, uint32_t frame) {
+    uint32_t dirty[CHIPS_FB_DIRTY_WORDS(HEIGHT)] = {0};
+    for (int i = rand() % 8; i > 0; i--) {
+        int y = rand() % HEIGHT;
+        chips_fb_dirty_set(dirty, y);
+        memset(&fb[y * PITCH], row_value(frame, y), PITCH);
+    }
+    shmfb_publish(shm, fb, dirty, NULL);
+}
+
+static void* reader(void* arg) {
+    (void)arg;
+    const shmfb_frame_t* f = shmfb_attach(name);
+    static uint8_t copy[PITCH * HEIGHT];
+    static uint32_t row_frame[HEIGHT];
+    uint32_t reads = 0, retries = 0;
+    while (!atomic_load(&done) && f) {
+        uint32_t frame, sequence;
+        do {
+            sequence = shmfb_read_begin(f);
+            frame = f->frame;
+            memcpy(copy, f->fb, sizeof(copy));
+            memcpy(row_frame, f->row_frame, sizeof(row_frame));
+            retries++;
+        } while (shmfb_read_retry(f, sequence));
+        retries--;
+        reads++;
+        for (int y = 0; y < HEIGHT; y++) {
+            uint8_t expected = row_value(row_frame[y], y);
+            if ((row_frame[y] > frame) || (copy[y * PITCH] != expected) || (copy[y * PITCH + PITCH - 1] != expected)) {
+                printf("FAIL torn frame %u row %d\n", frame, y);
+                failures++;
+                atomic_store(&done, true);
+                break;
+            }
+        }
+    }
+    printf("reader: %u consistent frames, %u retries\n", reads, retries);
+    if (f) {
+        shmfb_detach(f);
+    }
+    return NULL;
+}
+
+int main(void) {
+    srand(1);
+    snprintf(name, sizeof(name), "/chips-shmfb-test-%d", (int)getpid());
+    check(shmfb_attach(name) == NULL, "attach before open fails");
+
+    shmfb_t shm;
+    if (!shmfb_open(&shm, &(shmfb_desc_t){name, WIDTH, HEIGHT, palette, 8})) {
+        printf("FAIL shmfb_open\n");
+        return 1;
+    }
+    const shmfb_frame_t* f = shmfb_attach(name);
+    check(f && (f->width == WIDTH) && (f->height == HEIGHT) && (f->pitch == PITCH) && (f->num_colors == 8) &&
+              (f->palette[4] == palette[4]),
+          "segment header");
+    if (!f) {
+        shmfb_close(&shm);
+        return 1;
+    }
+
+    // Full first frame, then single rows
+    memset(fb, 0x11, sizeof(fb));
+    shmfb_publish(&shm, fb, NULL, NULL);
+    check((f->frame == 1) && (f->row_frame[HEIGHT - 1] == 1) && (f->fb[sizeof(fb) - 1] == 0x11), "full frame");
+    uint32_t dirty[CHIPS_FB_DIRTY_WORDS(HEIGHT)] = {0};
+    chips_fb_dirty_set(dirty, 100);
+    memset(&fb[100 * PITCH], 0x22, PITCH);
+    memset(&fb[101 * PITCH], 0x33, PITCH);  // Not flagged, stays unpublished
+    shmfb_publish(&shm, fb, dirty, NULL);
+    check((f->frame == 2) && (f->row_frame[100] == 2) && (f->row_frame[101] == 1) && (f->fb[100 * PITCH] == 0x22) &&
+              (f->fb[101 * PITCH] == 0x11) && (memcmp(f->dirty_rows, dirty, sizeof(dirty)) == 0),
+          "dirty rows");
+    // Row index, scanline 101 shows fb row 100
+    uint8_t lines[HEIGHT];
+    for (int y = 0; y < HEIGHT; y++) {
+        lines[y] = (uint8_t)((y == 101) ? 100 : y);
+    }
+    memset(dirty, 0, sizeof(dirty));
+    chips_fb_dirty_set(dirty, 101);
+    shmfb_publish(&shm, fb, dirty, lines);
+    check((f->row_frame[101] == 3) && (f->fb[101 * PITCH] == 0x22), "row index");
+    check((shmfb_read_begin(f) & 1) == 0, "sequence even between frames");
+
+    // Concurrent reader, starting from a full frame in the row_value() pattern
+    uint32_t first = f->frame + 1;
+    for (int y = 0; y < HEIGHT; y++) {
+        memset(&fb[y * PITCH], row_value(first, y), PITCH);
+    }
+    shmfb_publish(&shm, fb, NULL, NULL);
+    pthread_t thread;
+    pthread_create(&thread, NULL, reader, NULL);
+    for (uint32_t frame = first + 1; (frame < first + FRAMES) && !atomic_load(&done); frame++) {
+        publish(&shm, frame);
+    }
+    atomic_store(&done, true);
+    pthread_join(thread, NULL);
+
+    shmfb_detach(f);
+    shmfb_close(&shm);
+    check(shmfb_attach(name) == NULL, "segment removed on close");
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for the 65C02 on the Pico's GPIO bus
+//
+// The real CPU is a chip wired to the RP2040, so host tests have no CPU.
+// The stand-in keeps the bus idle: every tick reads address 0. Tests drive
+// the system state and the chips directly.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static uint8_t _wdc65C02cpu_data;
+
+static inline void wdc65C02cpu_init(void) {}
+
+static inline void wdc65C02cpu_reset(void) {}
+
+static inline void wdc65C02cpu_nmi(void) {}
+
+static inline void wdc65C02cpu_tick(uint16_t* addr, bool* rw) {
+    *addr = 0;
+    *rw = true;
+}
+
+static inline uint16_t wdc65C02cpu_get_address(void) { return 0; }
+
+static inline uint8_t wdc65C02cpu_get_data(void) { return _wdc65C02cpu_data; }
+
+static inline void wdc65C02cpu_set_data(uint8_t data) { _wdc65C02cpu_data = data; }
+
+static inline void wdc65C02cpu_set_irq(bool state) { (void)state; }
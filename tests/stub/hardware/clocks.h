@@ -0,0 +1,9 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "hardware/clocks.h", the system clock runs at 125 MHz
+#define CLOCKS_FC0_SRC_VALUE_CLK_SYS (9)
+
+static inline uint frequency_count_khz(uint src) {
+    (void)src;
+    return 125000;
+}
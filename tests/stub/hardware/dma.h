@@ -0,0 +1,64 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "hardware/dma.h"
+//
+// The registers are plain memory holding host pointers, nothing transfers.
+// Channels are claimed in order from 0, a host simulation reads back what
+// the code under test wrote, e.g. the buffer it queued in al1_read_addr.
+#define DMA_NUM_CHANNELS (12)
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    int chan;
+    int data_size;
+    bool read_increment;
+    bool write_increment;
+    int chain_to;
+    int dreq;
+} dma_channel_config;
+
+typedef struct {
+    struct {
+        uintptr_t read_addr, write_addr, transfer_count, ctrl_trig;
+        uintptr_t al1_read_addr, al3_read_addr_trig;
+    } ch[DMA_NUM_CHANNELS];
+    uintptr_t ints1;
+} dma_hw_t;
+
+static dma_hw_t dma_host_hw;
+static int dma_host_claimed;
+#define dma_hw (&dma_host_hw)
+
+static inline int dma_claim_unused_channel(bool required) {
+    (void)required;
+    return (dma_host_claimed < DMA_NUM_CHANNELS) ? dma_host_claimed++ : -1;
+}
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    return (dma_channel_config){.chan = (int)channel, .data_size = DMA_SIZE_32, .read_increment = true, .chain_to = (int)channel};
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) {
+    c->data_size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) { c->read_increment = incr; }
+
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) { c->write_increment = incr; }
+
+static inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to) { c->chain_to = (int)chain_to; }
+
+static inline void channel_config_set_dreq(dma_channel_config* c, uint dreq) { c->dreq = (int)dreq; }
+
+static inline void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+                                         const volatile void* read_addr, uint transfer_count, bool trigger) {
+    (void)config, (void)trigger;
+    dma_hw->ch[channel].write_addr = (uintptr_t)write_addr;
+    dma_hw->ch[channel].read_addr = (uintptr_t)read_addr;
+    dma_hw->ch[channel].transfer_count = transfer_count;
+}
+
+static inline void dma_channel_set_irq1_enabled(uint channel, bool enabled) { (void)channel, (void)enabled; }
+
+static inline void dma_channel_start(uint channel) { (void)channel; }
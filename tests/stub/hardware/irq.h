@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "hardware/irq.h"
+//
+// Handlers are only recorded, a host simulation raises an interrupt by
+// calling irq_host_handlers[num]().
+#define DMA_IRQ_1 (12)
+
+typedef void (*irq_handler_t)(void);
+
+static irq_handler_t irq_host_handlers[32];
+
+static inline void irq_set_exclusive_handler(uint num, irq_handler_t handler) { irq_host_handlers[num] = handler; }
+
+static inline void irq_set_enabled(uint num, bool enabled) { (void)num, (void)enabled; }
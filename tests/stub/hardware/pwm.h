@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "hardware/pwm.h", the registers are plain memory
+#define DREQ_PWM_WRAP0 (24)
+
+typedef struct {
+    float clkdiv;
+    uint16_t wrap;
+} pwm_config;
+
+typedef struct {
+    struct {
+        uintptr_t csr, div, ctr, cc, top;
+    } slice[8];
+} pwm_hw_t;
+
+static pwm_hw_t pwm_host_hw;
+#define pwm_hw (&pwm_host_hw)
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 7; }
+
+static inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1; }
+
+static inline pwm_config pwm_get_default_config(void) { return (pwm_config){.clkdiv = 1.0f, .wrap = 0xFFFF}; }
+
+static inline void pwm_config_set_clkdiv(pwm_config* c, float div) { c->clkdiv = div; }
+
+static inline void pwm_config_set_wrap(pwm_config* c, uint16_t wrap) { c->wrap = wrap; }
+
+static inline void pwm_init(uint slice_num, pwm_config* c, bool start) { (void)slice_num, (void)c, (void)start; }
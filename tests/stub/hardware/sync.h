@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "hardware/sync.h", a single-threaded host needs no barriers
+#define __dmb()
+#define __wfi()
@@ -0,0 +1,10 @@
+#pragma once
+
+// Host stand-in for the Pico SDK's "pico/stdlib.h", see pico_host.h
+#include "pico_host.h"
+
+typedef unsigned int uint;
+
+#define GPIO_FUNC_PWM (4)
+
+static inline void gpio_set_function(uint gpio, int fn) { (void)gpio, (void)fn; }
@@ -0,0 +1,71 @@
+#pragma once
+
+// Host stand-ins for the Pico SDK, FatFs and TinyUSB
+//
+// Just enough for the system headers to build on the host: SRAM placement
+// attributes are dropped, file and USB storage access always fails and there
+// are no built-in disk images. Include before the chips headers, in place of
+// the frontend's "pico/stdlib.h", "tusb.h", "ff.h" and images/*.h.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func)  func
+#define __time_critical_func(func) func
+#define __isr
+
+typedef int FIL;
+typedef int FRESULT;
+typedef unsigned UINT;
+typedef unsigned FSIZE_t;
+
+#define FR_OK    (0)
+#define FA_READ  (1)
+#define FA_WRITE (2)
+
+static inline FRESULT f_open(FIL* fil, const char* path, int mode) {
+    (void)fil, (void)path, (void)mode;
+    return 1;
+}
+
+static inline FRESULT f_read(FIL* fil, void* buf, UINT size, UINT* read) {
+    (void)fil, (void)buf, (void)size;
+    *read = 0;
+    return 1;
+}
+
+static inline FRESULT f_write(FIL* fil, const void* buf, UINT size, UINT* written) {
+    (void)fil, (void)buf, (void)size;
+    *written = 0;
+    return 1;
+}
+
+static inline FRESULT f_lseek(FIL* fil, FSIZE_t offset) {
+    (void)fil, (void)offset;
+    return 1;
+}
+
+static inline FRESULT f_close(FIL* fil) {
+    (void)fil;
+    return FR_OK;
+}
+
+static inline FSIZE_t f_size(FIL* fil) {
+    (void)fil;
+    return 0;
+}
+
+static inline void tuh_task(void) {}
+
+static inline void sleep_us(uint64_t us) { (void)us; }
+
+bool msc_inquiry_complete = true;
+
+// No disk images, the tests insert their own
+uint8_t* apple2_nib_images[] = {0};
+uint8_t* apple2_po_images[] = {0};
+uint32_t apple2_po_image_sizes[] = {0};
+char* apple2_msc_images[] = {0};
+uint8_t* oric_nib_images[] = {0};
+uint8_t* oric_wave_images[] = {0};
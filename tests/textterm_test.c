@@ -0,0 +1,184 @@
+// textterm screen diffing
+//
+// Feeds a sequence of randomly edited text screens through textterm, replays
+// the ANSI output into a terminal grid and checks after every update that
+// the grid shows the screen, and that only the changed cells were written.
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chips/chips_common.h"
+#include "util/textterm.h"
+
+#define UPDATES 500
+
+// What the terminal shows
+typedef struct {
+    char chars[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];
+    uint8_t attrs[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];
+    uint8_t colors[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];
+} grid_t;
+
+static grid_t grid;
+static chips_text_screen_t screen;
+static textterm_t term;
+static int failures;
+
+// Apply the subset of ANSI sequences textterm writes, return the number of characters printed
+static int replay(const char* out, size_t size) {
+    int row = 0, col = 0, printed = 0;
+    uint8_t attrs = 0, colors = 0x07;
+    for (size_t i = 0; i < size;) {
+        if (out[i] != 0x1b) {
+            if ((row < CHIPS_TEXT_MAX_ROWS) && (col < CHIPS_TEXT_MAX_COLUMNS)) {
+                grid.chars[row][col] = out[i];
+                grid.attrs[row][col] = attrs;
+                grid.colors[row][col] = colors;
+            }
+            col++;
+            printed++;
+            i++;
+            continue;
+        }
+        // CSI: ESC [ params final
+        int params[8] = {0}, num_params = 1;
+        for (i += 2; (i < size) && (((out[i] >= '0') && (out[i] <= '9')) || (out[i] == ';')); i++) {
+            if (out[i] == ';') {
+                num_params++;
+            } else {
+                params[num_params - 1] = params[num_params - 1] * 10 + (out[i] - '0');
+            }
+        }
+        switch (out[i++]) {
+            case 'J':
+                memset(&grid, 0, sizeof(grid));
+                break;
+            case 'H':
+                row = params[0] - 1;
+                col = params[1] - 1;
+                break;
+            case 'm':
+                for (int p = 0; p < num_params; p++) {
+                    if (params[p] == 0) {
+                        attrs = 0;
+                        colors = 0x07;
+                    } else if (params[p] == 7) {
+                        attrs |= CHIPS_TEXT_INVERSE;
+                    } else if (params[p] == 5) {
+                        attrs |= CHIPS_TEXT_FLASH;
+                    } else if (params[p] == 1) {
+                        attrs |= CHIPS_TEXT_DOUBLE;
+                    } else if ((params[p] >= 30) && (params[p] <= 37)) {
+                        colors = (uint8_t)((colors & 0x70) | (params[p] - 30));
+                    } else if ((params[p] >= 40) && (params[p] <= 47)) {
+                        colors = (uint8_t)((colors & 0x07) | ((params[p] - 40) << 4));
+                    }
+                }
+                break;
+            default:
+                printf("FAIL unexpected escape sequence\n");
+                failures++;
+                break;
+        }
+    }
+    return printed;
+}
+
+// Compare the grid with the screen as textterm shows it
+static bool grid_matches(void) {
+    const uint8_t shown_attrs = CHIPS_TEXT_INVERSE | CHIPS_TEXT_FLASH | CHIPS_TEXT_DOUBLE;
+    for (int row = 0; row < screen.rows; row++) {
+        for (int col = 0; col < screen.columns; col++) {
+            char c = screen.chars[row][col];
+            if ((grid.chars[row][col] != (((c >= 0x20) && (c < 0x7F)) ? c : ' ')) ||
+                (grid.attrs[row][col] != (screen.attrs[row][col] & shown_attrs)) ||
+                (grid.colors[row][col] != (screen.colors[row][col] & 0x77))) {
+                printf("FAIL cell %d,%d\n", row, col);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void random_cell(int row, int col) {
+    screen.chars[row][col] = (char)(rand() % 0x80);
+    screen.attrs[row][col] = (rand() % 4) ? 0 : (uint8_t)(rand() & 0xF);
+    screen.colors[row][col] = (rand() % 4) ? 0x0F : (uint8_t)rand();
+}
+
+int main(void) {
+    srand(1);
+    // Apple II 40 column text
+    screen.columns = 40;
+    screen.rows = 24;
+    for (int row = 0; row < screen.rows; row++) {
+        for (int col = 0; col < screen.columns; col++) {
+            random_cell(row, col);
+        }
+    }
+
+    char* out = NULL;
+    size_t size = 0;
+    for (int update = 0; (update < UPDATES) && (failures == 0); update++) {
+        int expected_cells = screen.rows * screen.columns;
+        if (update == 100) {
+            // Oric 40 x 28
+            screen.rows = 28;
+            expected_cells = screen.rows * screen.columns;
+        } else if (update == 300) {
+            // //e 80 columns
+            screen.columns = 80;
+            screen.rows = 24;
+            expected_cells = screen.rows * screen.columns;
+            for (int row = 0; row < screen.rows; row++) {
+                for (int col = 40; col < screen.columns; col++) {
+                    random_cell(row, col);
+                }
+            }
+        } else if (update == 400) {
+            textterm_invalidate(&term);
+        } else if (update > 0) {
+            // Edits, some of them rewriting a cell with the same contents
+            expected_cells = 0;
+            int edits = rand() % 20;
+            static bool changed[CHIPS_TEXT_MAX_ROWS][CHIPS_TEXT_MAX_COLUMNS];
+            memset(changed, 0, sizeof(changed));
+            for (int i = 0; i < edits; i++) {
+                int row = rand() % screen.rows;
+                int col = rand() % screen.columns;
+                if (rand() & 1) {
+                    random_cell(row, col);
+                }
+                if (!changed[row][col] && ((screen.chars[row][col] != term.prev.chars[row][col]) ||
+                                           (screen.attrs[row][col] != term.prev.attrs[row][col]) ||
+                                           (screen.colors[row][col] != term.prev.colors[row][col]))) {
+                    changed[row][col] = true;
+                    expected_cells++;
+                }
+            }
+        }
+
+        FILE* file = open_memstream(&out, &size);
+        if (update == 0) {
+            textterm_init(&term, file);
+        } else {
+            term.file = file;
+        }
+        int cells = textterm_update(&term, &screen);
+        fclose(file);
+        if ((replay(out, size) != cells) || (cells != expected_cells)) {
+            printf("FAIL update %d wrote %d cells, expected %d\n", update, cells, expected_cells);
+            failures++;
+        }
+        if (!grid_matches()) {
+            printf("FAIL update %d\n", update);
+            failures++;
+        }
+        free(out);
+        out = NULL;
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// triplebuf two-thread hammer
+//
+// A producer thread publishes frames as fast as it can, each rewriting the
+// header row with its frame number and a pseudo-random set of other rows
+// with the same number, the consumer thread checks every frame it gets:
+// each row must hold the number of the frame that last rewrote it, up to the
+// frame in the header. Any torn or stale row fails. Runs both the copying
+// triplebuf_publish() and the in-place triplebuf_publish_back() producers.
+// Also clean under ThreadSanitizer (-DCMAKE_C_FLAGS=-fsanitize=thread).
+#define CHIPS_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "chips/chips_common.h"
+#include "util/triplebuf.h"
+
+#define PITCH  120  // Oric
+#define HEIGHT 224
+#define FRAMES 100000
+
+static triplebuf_t tb;
+static uint8_t buffers[3 * PITCH * HEIGHT];
+static uint8_t fb[PITCH * HEIGHT];
+static bool in_place;
+static atomic_bool done;
+static int failures;
+
+// Row y is rewritten by frame n, row 0 by every frame
+static bool rewrites(uint32_t n, int y) { return (y == 0) || (((n * 2654435761u) ^ (y * 40503u)) % 7 == 0); }
+
+static void stamp(uint8_t* row, uint32_t n) {
+    for (int x = 0; x < PITCH; x += 4) {
+        memcpy(&row[x], &n, 4);
+    }
+}
+
+static void* producer(void* arg) {
+    (void)arg;
+    for (uint32_t n = 1; n <= FRAMES; n++) {
+        uint8_t* dst = in_place ? triplebuf_back(&tb) : fb;
+        uint32_t dirty[CHIPS_FB_DIRTY_WORDS(HEIGHT)] = {0};
+        for (int y = 0; y < HEIGHT; y++) {
+            if (rewrites(n, y)) {
+                stamp(&dst[y * PITCH], n);
+                chips_fb_dirty_set(dirty, y);
+            }
+        }
+        if (in_place) {
+            triplebuf_publish_back(&tb, dirty);
+        } else {
+            triplebuf_publish(&tb, fb, dirty);
+        }
+    }
+    atomic_store(&done, true);
+    return NULL;
+}
+
+static bool check_frame(const uint8_t* frame, uint32_t* last) {
+    uint32_t n;
+    memcpy(&n, frame, 4);
+    if (n < *last) {
+        printf("FAIL frame %u after frame %u\n", n, *last);
+        return false;
+    }
+    *last = n;
+    for (int y = 0; y < HEIGHT; y++) {
+        // The frame that last rewrote row y, 0 if none did
+        uint32_t expected = n;
+        while ((expected > 0) && !rewrites(expected, y)) {
+            expected--;
+        }
+        const uint8_t* row = &frame[y * PITCH];
+        for (int x = 0; x < PITCH; x += 4) {
+            uint32_t v;
+            memcpy(&v, &row[x], 4);
+            if (v != expected) {
+                printf("FAIL frame %u row %d holds %u, expected %u\n", n, y, v, expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void run(bool publish_back) {
+    in_place = publish_back;
+    atomic_store(&done, false);
+    memset(fb, 0, sizeof(fb));
+    triplebuf_init(&tb, &(triplebuf_desc_t){.pitch = PITCH, .height = HEIGHT, .buffers = {buffers, sizeof(buffers)}});
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, NULL);
+    uint32_t last = 0, checked = 0, distinct = 0;
+    bool finished;
+    do {
+        finished = atomic_load(&done);
+        uint32_t prev = last;
+        if (!check_frame(triplebuf_consume(&tb), &last)) {
+            failures++;
+            break;
+        }
+        checked++;
+        distinct += (last != prev);
+    } while (!finished);
+    pthread_join(thread, NULL);
+    if (!check_frame(triplebuf_consume(&tb), &last) || (last != FRAMES)) {
+        printf("FAIL last frame %u\n", last);
+        failures++;
+    }
+    printf("%s: %u frames checked, %u distinct\n", publish_back ? "publish_back" : "publish", checked, distinct);
+}
+
+int main(void) {
+    run(false);
+    run(true);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
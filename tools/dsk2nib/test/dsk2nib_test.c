@@ -0,0 +1,269 @@
+// dsk2nib against the converter it replaced
+//
+// The NIB images dsk2nib writes must not change now that the track encoder
+// lives in devices/disk2_nib.h. Converts DSK images (random sector data, all
+// zeros, all ones and a byte ramp) in DOS and ProDOS order with the encoder
+// loop of src/main.c and with the old converter below, copied from dsk2nib
+// before the move, and compares the NIB images byte for byte. Then inserts
+// each DSK image into a drive and reads every track through
+// disk2_fdd_read_byte(), which must return the same NIB bytes. Exits nonzero
+// on any difference.
+//
+// Build from this directory with: cc -I../../src -o dsk2nib_test test/dsk2nib_test.c
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHIPS_IMPL
+#include "devices/disk2_nib.h"
+#include "devices/disk2_fdd.h"
+
+/*-- the old converter -------------------------------------------------------*/
+#define TRACKS_PER_DISK   35
+#define SECTORS_PER_TRACK 16
+#define BYTES_PER_SECTOR  256
+#define BYTES_PER_TRACK   (SECTORS_PER_TRACK * BYTES_PER_SECTOR)
+#define DSK_IMAGE_SIZE    (TRACKS_PER_DISK * BYTES_PER_TRACK)
+
+#define BYTES_PER_NIB_SECTOR 374
+#define BYTES_PER_NIB_TRACK  (SECTORS_PER_TRACK * BYTES_PER_NIB_SECTOR)
+#define NIB_IMAGE_SIZE       (TRACKS_PER_DISK * BYTES_PER_NIB_TRACK)
+
+#define PRIMARY_BUF_LEN   256
+#define SECONDARY_BUF_LEN 86
+#define DATA_LEN          (PRIMARY_BUF_LEN + SECONDARY_BUF_LEN)
+
+#define PROLOG_LEN 3
+#define EPILOG_LEN 3
+#define GAP1_LEN   6
+#define GAP2_LEN   5
+
+#define DEFAULT_VOLUME 254
+#define GAP_BYTE       0xff
+
+typedef struct {
+    uint8_t prolog[PROLOG_LEN];
+    uint8_t volume[2];
+    uint8_t track[2];
+    uint8_t sector[2];
+    uint8_t checksum[2];
+    uint8_t epilog[EPILOG_LEN];
+} addr_t;
+
+typedef struct {
+    uint8_t prolog[PROLOG_LEN];
+    uint8_t data[DATA_LEN];
+    uint8_t checksum;
+    uint8_t epilog[EPILOG_LEN];
+} data_t;
+
+typedef struct {
+    uint8_t gap1[GAP1_LEN];
+    addr_t addr;
+    uint8_t gap2[GAP2_LEN];
+    data_t data;
+} nib_sector_t;
+
+static uint8_t addr_prolog[] = {0xd5, 0xaa, 0x96};
+static uint8_t addr_epilog[] = {0xde, 0xaa, 0xeb};
+static uint8_t data_prolog[] = {0xd5, 0xaa, 0xad};
+static uint8_t data_epilog[] = {0xde, 0xaa, 0xeb};
+
+// clang-format off
+static uint8_t soft_interleave[SECTORS_PER_TRACK] = 
+    {0, 7, 0xE, 6, 0xD, 5, 0xC, 4, 0xB, 3, 0xA, 2, 9, 1, 8, 0xF};
+static uint8_t phys_interleave[SECTORS_PER_TRACK] = 
+    {0, 0xD, 0xB, 9, 7, 5, 3, 1, 0xE, 0xC, 0xA, 8, 6, 4, 2, 0xF};
+// clang-format on
+
+// clang-format off
+static uint8_t soft_interleave_po[SECTORS_PER_TRACK] = 
+    {0, 8, 1, 9, 2, 0xA, 3, 0xB, 4, 0xC, 5, 0xD, 6, 0xE, 7, 0xF};
+static uint8_t phys_interleave_po[SECTORS_PER_TRACK] = 
+    {0, 2, 4, 6, 8, 0xA, 0xC, 0xE, 1, 3, 5, 7, 9, 0xB, 0xD, 0xF};
+// clang-format on
+
+static uint8_t primary_buf[PRIMARY_BUF_LEN];
+static uint8_t secondary_buf[SECONDARY_BUF_LEN];
+
+static nib_sector_t nib_sector;
+
+// Do "6 and 2" un-translation
+#define TABLE_SIZE 0x40
+// clang-format off
+static uint8_t table[TABLE_SIZE] = {
+    0x96, 0x97, 0x9a, 0x9b, 0x9d, 0x9e, 0x9f, 0xa6,
+    0xa7, 0xab, 0xac, 0xad, 0xae, 0xaf, 0xb2, 0xb3,
+    0xb4, 0xb5, 0xb6, 0xb7, 0xb9, 0xba, 0xbb, 0xbc,
+    0xbd, 0xbe, 0xbf, 0xcb, 0xcd, 0xce, 0xcf, 0xd3,
+    0xd6, 0xd7, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde,
+    0xdf, 0xe5, 0xe6, 0xe7, 0xe9, 0xea, 0xeb, 0xec,
+    0xed, 0xee, 0xef, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
+    0xf7, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+// clang-format on
+
+// Encode 1 byte into two "4 and 4" bytes
+static void odd_even_encode(uint8_t a[], int i) {
+    a[0] = (i >> 1) & 0x55;
+    a[0] |= 0xaa;
+
+    a[1] = i & 0x55;
+    a[1] |= 0xaa;
+}
+
+static uint8_t translate(uint8_t byte) { return table[byte & 0x3f]; }
+
+// Convert 256 data bytes into 342 6+2 encoded bytes and a checksum
+static void nibbilize(uint8_t track, uint8_t sector, uint8_t* dsk_image) {
+    uint8_t* src = dsk_image + track * BYTES_PER_TRACK + sector * BYTES_PER_SECTOR;
+    uint8_t* dest = nib_sector.data.data;
+
+    // Nibbilize data into primary and secondary buffers
+    memset(primary_buf, 0, PRIMARY_BUF_LEN);
+    memset(secondary_buf, 0, SECONDARY_BUF_LEN);
+
+    for (int i = 0; i < PRIMARY_BUF_LEN; i++) {
+        primary_buf[i] = src[i] >> 2;
+
+        int index = i % SECONDARY_BUF_LEN;
+        int section = i / SECONDARY_BUF_LEN;
+        uint8_t pair = ((src[i] & 2) >> 1) | ((src[i] & 1) << 1);  // Swap the low bits
+        secondary_buf[index] |= pair << (section * 2);
+    }
+
+    // Xor pairs of nibbilized bytes in correct order
+    int index = 0;
+    dest[index++] = translate(secondary_buf[0]);
+
+    for (int i = 1; i < SECONDARY_BUF_LEN; i++) {
+        dest[index++] = translate(secondary_buf[i] ^ secondary_buf[i - 1]);
+    }
+
+    dest[index++] = translate(primary_buf[0] ^ secondary_buf[SECONDARY_BUF_LEN - 1]);
+
+    for (int i = 1; i < PRIMARY_BUF_LEN; i++) {
+        dest[index++] = translate(primary_buf[i] ^ primary_buf[i - 1]);
+    }
+
+    nib_sector.data.checksum = translate(primary_buf[PRIMARY_BUF_LEN - 1]);
+}
+
+// The old convert_dsk_to_nib() without the file I/O
+static void old_convert_dsk_to_nib(uint8_t* dsk_image, uint8_t* nib_image, bool prodos_order) {
+    int volume = DEFAULT_VOLUME;
+
+    // Init addr & data field marks & volume number
+    memcpy(nib_sector.addr.prolog, addr_prolog, 3);
+    memcpy(nib_sector.addr.epilog, addr_epilog, 3);
+    memcpy(nib_sector.data.prolog, data_prolog, 3);
+    memcpy(nib_sector.data.epilog, data_epilog, 3);
+    odd_even_encode(nib_sector.addr.volume, volume);
+
+    // Init gap fields
+    memset(nib_sector.gap1, GAP_BYTE, GAP1_LEN);
+    memset(nib_sector.gap2, GAP_BYTE, GAP2_LEN);
+
+    // Loop through DSK tracks
+    for (int track = 0; track < TRACKS_PER_DISK; track++) {
+        // Loop through DSK sectors
+        for (int sector = 0; sector < SECTORS_PER_TRACK; sector++) {
+            int soft_sector = prodos_order ? soft_interleave_po[sector] : soft_interleave[sector];
+            int phys_sector = prodos_order ? phys_interleave_po[sector] : phys_interleave[sector];
+
+            // Set ADDR field contents
+            int checksum = volume ^ track ^ sector;
+            odd_even_encode(nib_sector.addr.track, track);
+            odd_even_encode(nib_sector.addr.sector, sector);
+            odd_even_encode(nib_sector.addr.checksum, checksum);
+
+            // Set DATA field contents (encode sector data)
+            nibbilize(track, soft_sector, dsk_image);
+
+            // Copy to NIB image buffer
+            uint8_t* buf = nib_image + track * BYTES_PER_NIB_TRACK + phys_sector * BYTES_PER_NIB_SECTOR;
+            memcpy(buf, &nib_sector, sizeof(nib_sector));
+        }
+    }
+}
+
+/*-- the test ----------------------------------------------------------------*/
+#define NUM_PATTERNS (4)
+
+static uint8_t dsk[DISK2_NIB_DSK_IMAGE_SIZE];
+static uint8_t old_nib[DISK2_NIB_NIB_IMAGE_SIZE];
+static uint8_t new_nib[DISK2_NIB_NIB_IMAGE_SIZE];
+static disk2_fdd_t fdd;
+
+static void fill_dsk(int pattern) {
+    srand(1);
+    for (int i = 0; i < DISK2_NIB_DSK_IMAGE_SIZE; i++) {
+        switch (pattern) {
+            case 0:
+                dsk[i] = (uint8_t)rand();
+                break;
+            case 1:
+                dsk[i] = 0x00;
+                break;
+            case 2:
+                dsk[i] = 0xFF;
+                break;
+            default:
+                dsk[i] = (uint8_t)i;
+                break;
+        }
+    }
+}
+
+// Same loop as convert_dsk_to_nib() in src/main.c
+static void new_convert_dsk_to_nib(disk2_nib_order_t order) {
+    for (int track = 0; track < DISK2_NIB_TRACKS_PER_DISK; track++) {
+        disk2_nib_encode_track(new_nib + track * DISK2_NIB_BYTES_PER_NIB_TRACK, dsk + track * DISK2_NIB_BYTES_PER_TRACK,
+                               track, DISK2_NIB_DEFAULT_VOLUME, order);
+    }
+}
+
+// Bytes read from the drive that differ from the NIB image, all half tracks, one revolution each
+static int read_dsk_mismatches(disk2_nib_order_t order) {
+    if (fdd.valid) {
+        disk2_fdd_discard(&fdd);
+    }
+    disk2_fdd_init(&fdd);
+    disk2_fdd_insert_dsk(&fdd, dsk, order);
+    disk2_fdd_set_motor_on(&fdd);
+    int mismatches = 0;
+    for (int half_track = 0; half_track < 2 * DISK2_NIB_TRACKS_PER_DISK; half_track++) {
+        fdd.half_track = half_track;
+        for (int i = 0; i < DISK2_NIB_BYTES_PER_NIB_TRACK; i++) {
+            // The head moves on before the byte under it is read
+            const uint8_t byte = disk2_fdd_read_byte(&fdd);
+            mismatches += byte != new_nib[(half_track / 2) * DISK2_NIB_BYTES_PER_NIB_TRACK + fdd.offset];
+        }
+    }
+    return mismatches;
+}
+
+int main(void) {
+    static const char* pattern_names[NUM_PATTERNS] = {"random", "zeros", "ones", "ramp"};
+    int failures = 0;
+    for (int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+        for (int prodos = 0; prodos < 2; prodos++) {
+            const disk2_nib_order_t order = prodos ? DISK2_NIB_ORDER_PRODOS : DISK2_NIB_ORDER_DOS;
+            fill_dsk(pattern);
+            old_convert_dsk_to_nib(dsk, old_nib, prodos);
+            new_convert_dsk_to_nib(order);
+            int diff = 0;
+            for (int i = 0; i < DISK2_NIB_NIB_IMAGE_SIZE; i++) {
+                diff += old_nib[i] != new_nib[i];
+            }
+            const int read_diff = read_dsk_mismatches(order);
+            printf("%-6s %-6s order: %d bytes differ from the old converter, %d read from the drive\n",
+                   pattern_names[pattern], prodos ? "ProDOS" : "DOS", diff, read_diff);
+            failures += (diff != 0) || (read_diff != 0);
+        }
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}